@@ -1,6 +1,7 @@
 #ifndef BITCOMBCOLEX_H
 #define BITCOMBCOLEX_H
 
+#include <bit>
 #include <cstdint>
 
 #include "util.h"
@@ -9,6 +10,9 @@
  * Co-lexicographic (colex) order.
  * See "Matters Computational" by Jörg Arndt, section 1.24.1
  * Implemented to be used in range-based for loop, no proper iterators/ranges.
+ * Combinations are numbered by their rank in this order (combinadic: sum
+ * of binomial coefficients C(position of i-th set bit, i)), so that
+ * iteration could start from any of them.
  */
 template<int n, int k>
 requires(0 < k && k <= n && n < 32)
@@ -16,7 +20,12 @@ class BitCombColexIt
 {
 public:
     using value_type = uint32_t;
-    struct Sentinel {};
+
+    // Marks combination of given rank as the end
+    struct Sentinel
+    {
+        value_type value;
+    };
 
     constexpr value_type operator*() const
     {
@@ -29,9 +38,9 @@ public:
         return *this;
     }
 
-    constexpr bool operator!=(Sentinel) const
+    constexpr bool operator!=(Sentinel end) const
     {
-        return notAtEnd();
+        return value_ != end.value;
     }
 
     // Set up the first combination of k bits,
@@ -40,6 +49,44 @@ public:
         : value_{nLeastBits<value_type>(k)}
     {}
 
+    // Set up combination of given rank (rank == C(n, k) is the end)
+    explicit constexpr BitCombColexIt(uint64_t rank)
+        : value_{unrank(rank)}
+    {}
+
+    constexpr uint64_t rank() const
+    {
+        return rank(value_);
+    }
+
+    static constexpr uint64_t rank(value_type value)
+    {
+        uint64_t res = 0;
+        int i = 0;
+
+        for (value_type v = value; v; v &= v - 1)
+            res += combinations(std::countr_zero(v), ++i);
+
+        return res;
+    }
+
+    static constexpr value_type unrank(uint64_t rank)
+    {
+        value_type res = 0;
+        int pos = n;
+
+        for (int i = k; i != 0; --i)
+        {
+            while (combinations(pos, i) > rank)
+                --pos;
+
+            rank -= combinations(pos, i);
+            res |= value_type{1} << pos--;
+        }
+
+        return res;
+    }
+
 private:
     constexpr void next()
     {
@@ -53,28 +100,52 @@ private:
         value_ |= (lowestBlock >> 1);  // need one bit less of low block
     }
 
-    constexpr bool notAtEnd() const
-    {
-        return (value_ & endMarker_) == 0;
-    }
-
-    static constexpr value_type endMarker_ = value_type{1} << n;
     value_type value_;
 };
 
+// All combinations or those with ranks in [first, last)
 template<int n, int k>
 class BitCombColex
 {
 public:
-    constexpr BitCombColexIt<n, k> begin() const
+    using It = BitCombColexIt<n, k>;
+
+    constexpr BitCombColex() = default;
+
+    constexpr BitCombColex(uint64_t first, uint64_t last)
+        : first_(first)
+        , last_(last)
+    {}
+
+    constexpr It begin() const
+    {
+        return It(first_);
+    }
+
+    constexpr It::Sentinel end() const
     {
-        return {};
+        return {It::unrank(last_)};
     }
 
-    constexpr BitCombColexIt<n, k>::Sentinel end() const
+    constexpr BitCombColex slice(uint64_t first, uint64_t last) const
     {
-        return {};
+        return {first_ + first, first_ + last};
     }
+
+    // Number of ranks (combinations)
+    static constexpr uint64_t size()
+    {
+        return combinations(n, k);
+    }
+
+    static constexpr uint64_t rank(uint32_t value)
+    {
+        return It::rank(value);
+    }
+
+private:
+    uint64_t first_ = 0;
+    uint64_t last_ = size();
 };
 
 #endif // BITCOMBCOLEX_H
@@ -52,3 +52,33 @@ TEST(BitCombColexTest, All)
     testBitCombColexN<7>();
     testBitCombColexN<10>();
 }
+
+// Rank of every combination is its position, unranking gives it back
+TEST(BitCombColexTest, RankUnrank)
+{
+    using It = BitCombColexIt<10, 4>;
+    uint64_t pos = 0;
+
+    for (It it; it != BitCombColex<10, 4>{}.end(); ++it, ++pos)
+    {
+        EXPECT_EQ(it.rank(), pos);
+        EXPECT_EQ(*It(pos), *it);
+    }
+
+    EXPECT_EQ(pos, (BitCombColex<10, 4>::size()));
+}
+
+TEST(BitCombColexTest, Slice)
+{
+    std::vector<uint32_t> all;
+    std::vector<uint32_t> sliced;
+
+    for (auto x: BitCombColex<9, 5>{})
+        all.push_back(x);
+
+    const auto slice = BitCombColex<9, 5>{}.slice(10, 100);
+    for (auto x: slice.slice(5, 20))
+        sliced.push_back(x);
+
+    EXPECT_EQ(sliced, std::vector(all.begin() + 15, all.begin() + 30));
+}
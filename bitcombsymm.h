@@ -0,0 +1,318 @@
+#ifndef BITCOMBSYMM_H
+#define BITCOMBSYMM_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "util.h"
+
+// Row combination (set of east rows) with weights for its mirror images
+struct SymmRows
+{
+    uint32_t rows;
+    unsigned northSouth; // 2 if also counts for north-south mirror, else 1
+    unsigned eastWest;   // same for east-west mirror (may be 0)
+};
+
+/* How east-west mirror (swapping sets of east and west rows) is weighted:
+ * none - not used at all (eastWest is always 1);
+ * separate - eastWest is computed, it is up to the caller when to use it;
+ * joint - eastWest is multiplied into northSouth (which may be up to 4).
+ */
+enum class EastWest { none, separate, joint };
+
+/* Row combinations (n bits total, k bits nonzero) reduced by north-south
+ * symmetry: a combination is produced only if it is not greater than its
+ * mirror image (rows reversed), and with joint east-west weight only
+ * if this weight is not zero. So every combination produced is processed,
+ * none is thrown away by the caller. Order is the same as in underlying
+ * BitComb, but ranks count produced combinations only (slice selects
+ * these ranks, so that every rank is a work item).
+ */
+template<template<int...> class BitComb, int n, int k, EastWest eastWest>
+requires(1 < n && n < 32)
+class BitCombSymm
+{
+    using Comb = BitComb<n, k>;
+    using Inner = decltype(Comb{}.begin());
+    using InnerEnd = decltype(Comb{}.end());
+
+public:
+    struct Sentinel {};
+
+    class Iterator
+    {
+    public:
+        using value_type = SymmRows;
+
+        Iterator(Inner it, InnerEnd end)
+            : it_(it)
+            , end_(end)
+        {
+            skip();
+        }
+
+        value_type operator*() const
+        {
+            return value_;
+        }
+
+        Iterator& operator++()
+        {
+            ++it_;
+            skip();
+            return *this;
+        }
+
+        bool operator!=(Sentinel) const
+        {
+            return it_ != end_;
+        }
+
+    private:
+        void skip()
+        {
+            for (; it_ != end_; ++it_)
+            {
+                value_ = weigh(*it_);
+
+                if (value_.northSouth)
+                    break;
+            }
+        }
+
+        Inner it_;
+        InnerEnd end_;
+        value_type value_ {};
+    };
+
+    constexpr BitCombSymm() = default;
+
+    // Combinations with ranks in [first, last)
+    constexpr BitCombSymm(uint64_t first, uint64_t last)
+        : first_(first)
+        , last_(last)
+    {}
+
+    Iterator begin() const
+    {
+        const Comb comb(combRank(first_), combRank(last_));
+        return Iterator(comb.begin(), comb.end());
+    }
+
+    Sentinel end() const
+    {
+        return {};
+    }
+
+    constexpr BitCombSymm slice(uint64_t first, uint64_t last) const
+    {
+        return {first_ + first, first_ + last};
+    }
+
+    // Number of produced combinations preceding this one
+    static constexpr uint64_t rank(const SymmRows& value)
+    {
+        uint64_t res = 0;
+        int i = 0;
+
+        for (uint32_t v = value.rows; v; v &= v - 1)
+        {
+            const int pos = std::countr_zero(v);
+            res += completions(value.rows & ~nLeastBits<uint32_t>(pos + 1),
+                               pos, ++i);
+        }
+
+        return res;
+    }
+
+    static constexpr uint32_t unrank(uint64_t rank)
+    {
+        uint32_t res = 0;
+        int bits = k;
+
+        for (int pos = n - 1; bits != 0; --pos)
+        {
+            const uint64_t below = completions(res, pos, bits);
+
+            if (rank >= below)
+            {
+                rank -= below;
+                res |= uint32_t{1} << pos;
+                --bits;
+            }
+        }
+
+        return res;
+    }
+
+    // Number of ranks (all of them are produced)
+    static constexpr uint64_t size()
+    {
+        return count();
+    }
+
+    static SymmRows weigh(uint32_t rows)
+    {
+        const uint32_t revRows = revBits<n, n / 2>(rows);
+        const unsigned northSouth = (rows != revRows)
+                ? ((rows < revRows)
+                   ? 2
+                   : 0)
+                : 1;
+
+        if constexpr (eastWest == EastWest::none)
+            return {rows, northSouth, 1};
+
+        const uint32_t eqRows = ~(rows ^ revRows) & allRows_;
+        const uint32_t eqBit = eqRows & -eqRows;
+        const unsigned ew = eqRows
+                ? ((rows & eqBit)
+                   ? 2
+                   : 0)
+                : 1;
+
+        if constexpr (eastWest == EastWest::joint)
+            return {rows, northSouth * ew, 1};
+        else
+            return {rows, northSouth, ew};
+    }
+
+    /* Number of combinations produced. Mirror images are considered
+     * pair by pair of rows (i, n - 1 - i), starting from outermost ones.
+     * The first unequal pair decides north-south weight (row i should be
+     * east one), the first equal pair decides east-west weight (both rows
+     * should be east ones).
+     */
+    static constexpr uint64_t count()
+    {
+        constexpr int pairs = n / 2;
+
+        if constexpr (eastWest == EastWest::joint)
+        {
+            static_assert(n == 2 * k, "east-west mirror needs half rows");
+            uint64_t res = uint64_t{1} << (pairs - 1); // all pairs unequal
+
+            // Equal pairs: as many "both east" as "both west"
+            for (int unequal = pairs % 2; unequal < pairs; unequal += 2)
+            {
+                const int east = (pairs - unequal) / 2;
+                const uint64_t unequalWays = unequal
+                        ? uint64_t{1} << (unequal - 1)
+                        : 1;
+                res += combinations(pairs, unequal) * unequalWays
+                       * combinations(pairs - unequal - 1, east - 1);
+            }
+
+            return res;
+        }
+        else
+        {
+            uint64_t palindromes = 0;
+
+            for (int middle = 0; middle <= n % 2; ++middle)
+            {
+                if ((k - middle) % 2 == 0)
+                    palindromes += combinations(pairs, (k - middle) / 2);
+            }
+
+            return (combinations(n, k) + palindromes) / 2;
+        }
+    }
+
+private:
+    // Rank in underlying BitComb
+    static constexpr uint64_t combRank(uint64_t rank)
+    {
+        return (rank == size()) ? Comb::size() : Comb::rank(unrank(rank));
+    }
+
+    /* Number of produced combinations having the same rows as "fixed"
+     * at positions from "free" up and "bits" more rows below "free".
+     * Pairs of rows are walked as in count(), ways[ns][ew][m] are numbers
+     * of ways to choose m free rows so far with north-south (ns)
+     * and east-west (ew) weights not yet decided or decided as nonzero.
+     */
+    static constexpr uint64_t completions(uint32_t fixed, int free, int bits)
+    {
+        if (bits > free)
+            return 0;
+
+        constexpr bool joint = (eastWest == EastWest::joint);
+        using Ways = std::array<std::array<std::array<uint64_t, k + 1>, 2>, 2>;
+        Ways ways {};
+        ways[0][0][0] = 1;
+
+        // Adds ways for given rows of a pair (or the middle row)
+        auto step = [&](int lo, int hi) {
+            Ways next {};
+
+            for (uint32_t x = 0; x != 4; ++x)
+            {
+                const uint32_t loRow = x & 1;
+                const uint32_t hiRow = x >> 1;
+                const bool loFree = (lo < free);
+                const bool hiFree = (hi < free);
+
+                if ((!loFree && loRow != ((fixed >> lo) & 1))
+                    || (!hiFree && hiRow != ((fixed >> hi) & 1))
+                    || (lo == hi && loRow != hiRow))
+                    continue;
+
+                const int cost = (loFree && loRow)
+                        + (hiFree && hiRow && lo != hi);
+
+                for (int ns = 0; ns != 2; ++ns)
+                {
+                    for (int ew = 0; ew != 2; ++ew)
+                    {
+                        int nextNs = ns;
+                        int nextEw = ew;
+
+                        if (loRow != hiRow && !ns)
+                        {
+                            if (!loRow)
+                                continue; // greater than mirror image
+                            nextNs = 1;
+                        }
+
+                        if (loRow == hiRow && joint && !ew)
+                        {
+                            if (!loRow)
+                                continue; // zero east-west weight
+                            nextEw = 1;
+                        }
+
+                        for (int m = 0; m + cost <= bits; ++m)
+                            next[nextNs][nextEw][m + cost] += ways[ns][ew][m];
+                    }
+                }
+            }
+
+            ways = next;
+        };
+
+        for (int i = 0; i != n / 2; ++i)
+            step(i, n - 1 - i);
+
+        if constexpr (n % 2 != 0)
+            step(n / 2, n / 2);
+
+        uint64_t res = 0;
+
+        for (const auto& w: ways)
+        {
+            for (const auto& m: w)
+                res += m[bits];
+        }
+
+        return res;
+    }
+
+    static constexpr uint32_t allRows_ = nLeastBits<uint32_t>(n);
+    uint64_t first_ = 0;
+    uint64_t last_ = size();
+};
+
+#endif // BITCOMBSYMM_H
@@ -0,0 +1,101 @@
+#include "bitcombsymm.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "bitcombcolex.h"
+#include "util.h"
+
+template<int n, int k, EastWest eastWest>
+void testBitCombSymmNK()
+{
+    using Comb = BitCombSymm<BitCombColex, n, k, eastWest>;
+    std::vector<SymmRows> sink;
+
+    for (auto x: Comb{})
+        sink.push_back(x);
+
+    EXPECT_EQ(sink.size(), Comb::count());
+    EXPECT_EQ(sink.size(), Comb::size());
+
+    uint64_t weighted = 0;
+    std::set<uint32_t> covered;
+
+    for (uint64_t rank = 0; const auto& x: sink)
+    {
+        EXPECT_EQ(Comb::rank(x), rank);
+        EXPECT_EQ(Comb::unrank(rank++), x.rows);
+        EXPECT_NE(x.northSouth, 0u);
+        EXPECT_LE(x.rows, (revBits<n, n / 2>(x.rows)));
+        weighted += uint64_t{x.northSouth} * x.eastWest;
+        for (uint32_t rows: {x.rows, revBits<n, n / 2>(x.rows)})
+        {
+            covered.insert(rows);
+
+            if (eastWest == EastWest::joint)
+                covered.insert(rows ^ nLeastBits<uint32_t>(n));
+        }
+    }
+
+    // Every combination is either produced or mirrored from produced one
+    EXPECT_EQ(covered.size(), combinations(n, k));
+
+    // Weights account for every combination exactly once
+    EXPECT_EQ(weighted, combinations(n, k));
+}
+
+TEST(BitCombSymmTest, NorthSouth)
+{
+    testBitCombSymmNK<2, 1, EastWest::none>();
+    testBitCombSymmNK<7, 3, EastWest::none>();
+    testBitCombSymmNK<7, 4, EastWest::none>();
+    testBitCombSymmNK<9, 5, EastWest::none>();
+    testBitCombSymmNK<10, 5, EastWest::none>();
+}
+
+TEST(BitCombSymmTest, SeparateEastWest)
+{
+    testBitCombSymmNK<4, 2, EastWest::separate>();
+    testBitCombSymmNK<8, 4, EastWest::separate>();
+    testBitCombSymmNK<12, 6, EastWest::separate>();
+}
+
+TEST(BitCombSymmTest, JointEastWest)
+{
+    testBitCombSymmNK<2, 1, EastWest::joint>();
+    testBitCombSymmNK<4, 2, EastWest::joint>();
+    testBitCombSymmNK<6, 3, EastWest::joint>();
+    testBitCombSymmNK<10, 5, EastWest::joint>();
+    testBitCombSymmNK<12, 6, EastWest::joint>();
+}
+
+// Every rank is produced by exactly one slice
+TEST(BitCombSymmTest, Slices)
+{
+    using Comb = BitCombSymm<BitCombColex, 10, 5, EastWest::joint>;
+    std::vector<uint32_t> whole;
+    std::vector<uint32_t> sliced;
+
+    for (auto x: Comb{})
+        whole.push_back(x.rows);
+
+    for (uint64_t first = 0; first < Comb::size(); first += 7)
+    {
+        const uint64_t last = std::min(first + 7, Comb::size());
+        std::size_t produced = 0;
+
+        for (auto x: Comb{}.slice(first, last))
+        {
+            sliced.push_back(x.rows);
+            ++produced;
+        }
+
+        EXPECT_EQ(produced, last - first);
+    }
+
+    EXPECT_EQ(sliced, whole);
+}
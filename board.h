@@ -16,6 +16,15 @@ class Board
 public:
     Board() = default;
 
+    // Board with given sets of occupied rows, columns and diagonals
+    static Board occupied(uint32_t rows,
+                          uint32_t columns,
+                          uint32_t diags0,
+                          uint32_t diags1)
+    {
+        return {rows ^ allRC, columns ^ allRC, ~diags0, ~diags1};
+    }
+
     uint32_t getFreeColumns(int row) const
     {
         return columns_
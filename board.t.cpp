@@ -48,3 +48,15 @@ TEST(BoardTest, Queens1of8)
     EXPECT_EQ(b.diags(0), 1u << 7);
     EXPECT_EQ(b.diags(1), 0b10000u);
 }
+
+TEST(BoardTest, Occupied)
+{
+    Board<8> empty;
+    auto b = empty.addQueen(2, 0b100).addQueen(5, 0b1);
+    auto o = Board<8>::occupied(b.rows(), b.columns(), b.diags(0), b.diags(1));
+    EXPECT_EQ(o.rows(), b.rows());
+    EXPECT_EQ(o.columns(), b.columns());
+    EXPECT_EQ(o.diags(0), b.diags(0));
+    EXPECT_EQ(o.diags(1), b.diags(1));
+    EXPECT_EQ(o.getFreeColumns(3), b.getFreeColumns(3));
+}
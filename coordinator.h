@@ -0,0 +1,278 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Runs units of work (ranges of work items, see Divider) by several local
+ * worker processes. Workers are forked from the coordinator (before it
+ * starts any threads) and talk to it over Unix sockets: the coordinator
+ * sends "first last" lines, worker replies "first last result" for each
+ * of them and exits when its socket is closed. A worker that exits
+ * or crashes before replying is replaced by a new one, and its unit goes
+ * back to the queue (every unit is tried at most maxAttempts times).
+ *
+ * Linux only.
+ */
+class Coordinator
+{
+public:
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    explicit Coordinator(std::vector<Range> units, int maxAttempts = 3)
+        : queue_(units.begin(), units.end())
+        , maxAttempts_(maxAttempts)
+    {}
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator=(const Coordinator&) = delete;
+
+    // Workers are left only if run() has failed
+    ~Coordinator()
+    {
+        while (!workers_.empty())
+            stop(workers_.size() - 1);
+    }
+
+    /* Worker process calls serve(next, reply): next(range) gets next unit
+     * (returns false when there is no more work), reply(range, result)
+     * returns the result. Coordinator calls report(range, result) for every
+     * unit done and returns the sum of results.
+     */
+    uint64_t run(int workers, const auto& serve, const auto& report)
+    {
+        signal(SIGPIPE, SIG_IGN); // failed worker is detected by poll()
+
+        for (int i = 0; i != workers && !queue_.empty(); ++i)
+            spawn(serve);
+
+        uint64_t total = 0;
+
+        while (!workers_.empty())
+        {
+            std::vector<pollfd> fds;
+
+            for (const Worker& w: workers_)
+                fds.push_back({w.fd, POLLIN, 0});
+
+            if (poll(fds.data(), fds.size(), -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                fail("poll");
+            }
+
+            // Workers may be removed or added while walking through them
+            for (std::size_t i = fds.size(); i-- != 0; )
+            {
+                if (fds[i].revents == 0)
+                    continue;
+
+                if (!receive(workers_[i], total, report))
+                    retire(i, serve);
+            }
+        }
+
+        return total;
+    }
+
+private:
+    struct Worker
+    {
+        pid_t pid;
+        int fd;
+        Range unit;
+        bool busy;
+        std::string input;
+        int attempts; // of the current unit
+    };
+
+    struct Queued
+    {
+        Range unit;
+        int attempts;
+    };
+
+    void spawn(const auto& serve)
+    {
+        int sv[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+            fail("socketpair");
+
+        const pid_t pid = fork();
+
+        if (pid < 0)
+            fail("fork");
+
+        if (pid == 0)
+        {
+            signal(SIGINT, SIG_DFL); // coordinator's handlers are not needed
+            signal(SIGTERM, SIG_DFL);
+            close(sv[0]);
+
+            for (const Worker& w: workers_)
+                close(w.fd);
+
+            const int fd = sv[1];
+
+            try
+            {
+                serve([fd](Range& unit) { return readUnit(fd, unit); },
+                      [fd](Range unit, uint64_t result) {
+                          writeLine(fd, std::to_string(unit.first) + ' '
+                                    + std::to_string(unit.second) + ' '
+                                    + std::to_string(result) + '\n');
+                      });
+            }
+            catch (...)
+            {
+                _exit(EXIT_FAILURE); // the unit is tried again
+            }
+
+            _exit(EXIT_SUCCESS);
+        }
+
+        close(sv[1]);
+        workers_.push_back({pid, sv[0], {}, false, {}, 0});
+        dispatch(workers_.back());
+    }
+
+    // Sends next unit to the worker, or closes its socket if there is none
+    void dispatch(Worker& w)
+    {
+        if (queue_.empty())
+        {
+            shutdown(w.fd, SHUT_WR);
+            return;
+        }
+
+        const Queued q = queue_.front();
+        queue_.pop_front();
+        w.unit = q.unit;
+        w.attempts = q.attempts + 1;
+        w.busy = true;
+        writeLine(w.fd, std::to_string(q.unit.first) + ' '
+                  + std::to_string(q.unit.second) + '\n');
+    }
+
+    // Reads results of the worker, returns false if it has finished
+    bool receive(Worker& w, uint64_t& total, const auto& report)
+    {
+        char buf[256];
+        const ssize_t len = read(w.fd, buf, sizeof(buf));
+
+        if (len <= 0)
+            return false;
+
+        w.input.append(buf, static_cast<std::size_t>(len));
+
+        for (std::size_t eol; (eol = w.input.find('\n')) != std::string::npos; )
+        {
+            std::istringstream is(w.input.substr(0, eol));
+            w.input.erase(0, eol + 1);
+            Range unit;
+            uint64_t result;
+
+            if (!(is >> unit.first >> unit.second >> result)
+                || !w.busy || unit != w.unit)
+                return false;
+
+            w.busy = false;
+            total += result;
+            report(unit, result);
+            dispatch(w);
+        }
+
+        return true;
+    }
+
+    // Removes finished (or failed) worker, its unit is tried again
+    void retire(std::size_t i, const auto& serve)
+    {
+        const Worker w = stop(i);
+
+        if (!w.busy)
+            return;
+
+        if (w.attempts >= maxAttempts_)
+        {
+            throw std::runtime_error(
+                        "Work items " + std::to_string(w.unit.first) + ".."
+                        + std::to_string(w.unit.second) + " failed "
+                        + std::to_string(w.attempts) + " times");
+        }
+
+        queue_.push_front({w.unit, w.attempts});
+        spawn(serve);
+    }
+
+    Worker stop(std::size_t i)
+    {
+        Worker w = std::move(workers_[i]);
+        workers_.erase(workers_.begin() + static_cast<std::ptrdiff_t>(i));
+        close(w.fd);
+        kill(w.pid, SIGKILL); // may be alive if protocol was broken
+        waitpid(w.pid, nullptr, 0);
+        return w;
+    }
+
+    static bool readUnit(int fd, Range& unit)
+    {
+        std::string line;
+        char c;
+
+        while (read(fd, &c, 1) == 1)
+        {
+            if (c == '\n')
+            {
+                std::istringstream is(line);
+                return static_cast<bool>(is >> unit.first >> unit.second);
+            }
+
+            line += c;
+        }
+
+        return false;
+    }
+
+    static void writeLine(int fd, const std::string& line)
+    {
+        // Failure is detected when reading from this worker
+        for (std::size_t pos = 0; pos != line.size(); )
+        {
+            const ssize_t len = write(fd, line.data() + pos, line.size() - pos);
+
+            if (len <= 0)
+                return;
+
+            pos += static_cast<std::size_t>(len);
+        }
+    }
+
+    [[noreturn]] static void fail(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    std::deque<Queued> queue_;
+    std::vector<Worker> workers_;
+    int maxAttempts_;
+};
+
+#endif // COORDINATOR_H
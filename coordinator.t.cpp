@@ -0,0 +1,85 @@
+#include "coordinator.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using Range = Coordinator::Range;
+
+namespace
+{
+std::vector<Range> makeUnits(uint64_t count)
+{
+    std::vector<Range> units;
+
+    for (uint64_t i = 0; i != count; ++i)
+        units.push_back({10 * i, 10 * i + 10});
+
+    return units;
+}
+
+// Result of a unit is the sum of its work items
+uint64_t sumOf(Range unit)
+{
+    return (unit.first + unit.second - 1) * (unit.second - unit.first) / 2;
+}
+}
+
+TEST(CoordinatorTest, AllUnits)
+{
+    Coordinator coordinator(makeUnits(20));
+    std::set<Range> reported;
+
+    const uint64_t total = coordinator.run(3, [](auto next, auto reply) {
+        for (Range unit; next(unit); )
+            reply(unit, sumOf(unit));
+    }, [&](Range unit, uint64_t result) {
+        EXPECT_EQ(result, sumOf(unit));
+        EXPECT_TRUE(reported.insert(unit).second);
+    });
+
+    EXPECT_EQ(reported.size(), 20u);
+    EXPECT_EQ(total, sumOf({0, 200}));
+}
+
+// Worker crashes once on some unit, the unit is given to a new worker
+TEST(CoordinatorTest, Reassign)
+{
+    const std::string marker = "/tmp/nqueens-crash-" + std::to_string(getpid());
+    Coordinator coordinator(makeUnits(10));
+
+    const uint64_t total = coordinator.run(2, [&](auto next, auto reply) {
+        for (Range unit; next(unit); )
+        {
+            if (unit.first == 50 && std::fopen(marker.c_str(), "wx"))
+                std::abort();
+
+            reply(unit, sumOf(unit));
+        }
+    }, [](Range, uint64_t) {});
+
+    std::remove(marker.c_str());
+    EXPECT_EQ(total, sumOf({0, 100}));
+}
+
+TEST(CoordinatorTest, TooManyAttempts)
+{
+    Coordinator coordinator(makeUnits(4), 2);
+
+    EXPECT_THROW(coordinator.run(2, [](auto next, auto reply) {
+        for (Range unit; next(unit); )
+        {
+            if (unit.first == 20)
+                throw std::runtime_error("failed");
+
+            reply(unit, 0);
+        }
+    }, [](Range, uint64_t) {}), std::runtime_error);
+}
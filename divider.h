@@ -1,17 +1,63 @@
 #ifndef DIVIDER_H
 #define DIVIDER_H
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+class Journal;
+class WorkPlan;
+
 /* Function object that returns false one out of "parts" times. May be useful
  * (1) to investigate long-running program, (2) to apply pgo, or (3) to divide
  * work into several smaller parts.
+ *
+ * Also selects ranges [first, last) of work items. Work items are numbered
+ * in the order they are visited: starts one after another, then their
+ * (col, row) configurations, then ranks of row combinations. Loops claim
+ * their items (and skip those outside of the ranges) in bulk, so that only
+ * selected items are walked through. Optional WorkPlan collects costs
+ * of work items, optional Journal records their subtotals (see
+ * Quadrants1::forClaimed).
  */
 class Divider
 {
 public:
-    Divider(int start = 0, int parts = 1)
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    static constexpr uint64_t all = std::numeric_limits<uint64_t>::max();
+
+    Divider(int start = 0,
+            int parts = 1,
+            uint64_t first = 0,
+            uint64_t last = all)
+        : Divider(start, parts, std::vector{Range(first, last)})
+    {}
+
+    // Several ranges (overlapping or adjacent ones are merged)
+    Divider(int start,
+            int parts,
+            std::vector<Range> ranges,
+            WorkPlan* plan = nullptr,
+            Journal* journal = nullptr)
         : counter_(start)
         , parts_(parts)
-    {}
+        , plan_(plan)
+        , journal_(journal)
+    {
+        std::ranges::sort(ranges);
+
+        for (const Range& r: ranges)
+        {
+            if (!ranges_.empty() && ranges_.back().second >= r.first)
+                ranges_.back().second = std::max(ranges_.back().second,
+                                                 r.second);
+            else if (r.first < r.second)
+                ranges_.push_back(r);
+        }
+    }
 
     bool operator() ()
     {
@@ -20,9 +66,65 @@ public:
         return counter_ != 0;
     }
 
+    /* Claims next "count" work items, calls action(first, last) for every
+     * selected part of them (relative to the first one).
+     */
+    void claim(uint64_t count, const auto& action)
+    {
+        base_ = pos_;
+        pos_ += count;
+
+        for (const auto& [first, last]: ranges_)
+        {
+            if (first < pos_ && last > base_)
+                action(std::max(first, base_) - base_,
+                       std::min(last, pos_) - base_);
+        }
+    }
+
+    // Claims next "count" work items (processed elsewhere)
+    void claim(uint64_t count)
+    {
+        pos_ += count;
+    }
+
+    // Claims next "count" work items only if none of them is selected
+    bool skip(uint64_t count)
+    {
+        for (const auto& [first, last]: ranges_)
+        {
+            if (first < pos_ + count && last > pos_)
+                return false;
+        }
+
+        pos_ += count;
+        return true;
+    }
+
+    // Number of item with given rank (relative to the last claim)
+    uint64_t item(uint64_t rank) const
+    {
+        return base_ + rank;
+    }
+
+    WorkPlan* plan() const
+    {
+        return plan_;
+    }
+
+    Journal* journal() const
+    {
+        return journal_;
+    }
+
 private:
     int counter_;
     int parts_;
+    std::vector<Range> ranges_;
+    WorkPlan* plan_;
+    Journal* journal_;
+    uint64_t pos_ = 0;
+    uint64_t base_ = 0;
 };
 
 #endif // DIVIDER_H
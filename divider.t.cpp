@@ -0,0 +1,65 @@
+#include "divider.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+using Range = Divider::Range;
+using Ranges = std::vector<Range>;
+
+// Selected parts of next "count" work items
+Ranges claimed(Divider& div, uint64_t count)
+{
+    Ranges res;
+    div.claim(count, [&res](uint64_t first, uint64_t last) {
+        res.push_back({first, last});
+    });
+    return res;
+}
+
+TEST(DividerTest, Parts)
+{
+    Divider div(1, 3);
+    EXPECT_TRUE(div());
+    EXPECT_FALSE(div());
+    EXPECT_TRUE(div());
+    EXPECT_TRUE(div());
+    EXPECT_FALSE(div());
+}
+
+TEST(DividerTest, ClaimRange)
+{
+    Divider div(0, 1, 15, 35);
+    EXPECT_EQ(claimed(div, 10), Ranges{});
+    EXPECT_EQ(claimed(div, 10), Ranges{Range(5, 10)});
+    EXPECT_EQ(claimed(div, 10), Ranges{Range(0, 10)});
+    EXPECT_EQ(div.item(3), 23u);
+    EXPECT_EQ(claimed(div, 10), Ranges{Range(0, 5)});
+    EXPECT_EQ(claimed(div, 10), Ranges{});
+}
+
+TEST(DividerTest, SkipRange)
+{
+    Divider div(0, 1, 15, 35);
+    EXPECT_TRUE(div.skip(10));
+    EXPECT_FALSE(div.skip(10)); // not claimed
+    EXPECT_EQ(claimed(div, 30), Ranges{Range(5, 25)});
+    EXPECT_TRUE(div.skip(10));
+}
+
+TEST(DividerTest, SeveralRanges)
+{
+    Divider div(0, 1, {{30, 40}, {5, 8}, {12, 20}, {18, 25}});
+    div.claim(10);
+    EXPECT_EQ(claimed(div, 20), (Ranges{{2, 15}}));
+    EXPECT_EQ(claimed(div, 20), (Ranges{{0, 10}}));
+    EXPECT_TRUE(div.skip(10));
+}
+
+TEST(DividerTest, All)
+{
+    Divider div;
+    EXPECT_FALSE(div.skip(1000));
+    EXPECT_EQ(claimed(div, 1000), Ranges{Range(0, 1000)});
+}
@@ -1,6 +1,8 @@
 #ifndef FREEZE_H
 #define FREEZE_H
 
+#include <array>
+#include <cstdint>
 #include <vector>
 
 #include "scheduler.h"
@@ -50,9 +52,19 @@ public:
         // else keep memory allocated, it will be reused
     }
 
+    /* Small values computed by one thread for the whole team. They are
+     * written and read in different steps, and these steps are separated
+     * by env.sync().
+     */
+    uint64_t& shared(int i)
+    {
+        return shared_[i];
+    }
+
 private:
     Obj obj_;
     std::vector<Obj*> ptrs_;
+    std::array<uint64_t, 2> shared_ {};
     mutable ThreadPolicy::Mutex mutex_;
 };
 
@@ -0,0 +1,213 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Journal of completed work items (see Divider), so that interrupted run
+ * could be resumed. The first line is "total <number of work items>",
+ * every other line "first last subtotal" means that work items
+ * [first, last) add "subtotal" to the result. Work items claimed at once
+ * are split into units (at multiples of unitSize), every unit is processed
+ * by a team of threads, each of them adds its share. A line is appended
+ * and synced to disk as soon as the whole team has finished the unit.
+ * Each line is written by a single write() call. When the journal
+ * is resumed, an incomplete last line (if the program was killed) is cut
+ * off, and entries that do not fit together are rejected.
+ *
+ * Linux only.
+ */
+class Journal
+{
+public:
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    struct Entry
+    {
+        Range range;
+        uint64_t subtotal;
+    };
+
+    // Contents of existing journal
+    struct Contents
+    {
+        std::vector<Entry> entries;
+        std::size_t bytes = 0; // size of complete lines
+    };
+
+    /* Starts new journal (existing file is truncated) or resumes existing
+     * one (throws if it is missing, belongs to other board size, or has
+     * invalid entries).
+     */
+    Journal(const char* path, uint64_t totalItems, bool resume)
+        : unitSize_(std::max<uint64_t>(1, (totalItems + maxUnits - 1)
+                                          / maxUnits))
+    {
+        if (resume)
+            resumed_ = read(path, totalItems);
+
+        const int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC
+                          | (resume ? 0 : O_TRUNC);
+        fd_ = open(path, flags, 0644);
+        if (fd_ < 0)
+            fail("Cannot open journal");
+
+        if (!resume)
+            append("total " + std::to_string(totalItems) + '\n');
+        else if (ftruncate(fd_, static_cast<off_t>(resumed_.bytes)) != 0)
+            fail("Cannot truncate journal");
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    ~Journal()
+    {
+        close(fd_);
+    }
+
+    // Entries of resumed journal
+    const Contents& resumed() const
+    {
+        return resumed_;
+    }
+
+    // End of the unit containing given item
+    uint64_t unitEnd(uint64_t item) const
+    {
+        return (item / unitSize_ + 1) * unitSize_;
+    }
+
+    // Share of one thread in a unit, the team has teamSize threads
+    void add(Range range, uint64_t subtotal, std::ptrdiff_t teamSize)
+    {
+        std::scoped_lock lock(mutex_);
+        Pending& p = pending_[range];
+        p.subtotal += subtotal;
+
+        if (++p.arrived == teamSize)
+        {
+            append(std::to_string(range.first) + ' '
+                   + std::to_string(range.second) + ' '
+                   + std::to_string(p.subtotal) + '\n');
+            pending_.erase(range);
+        }
+    }
+
+    // File descriptor to be synced by signal handler
+    int fd() const
+    {
+        return fd_;
+    }
+
+    /* Reads complete lines of the journal. Throws if the header does not
+     * match totalItems, or if some entry is malformed, is outside of
+     * [0, totalItems), or overlaps another one.
+     */
+    static Contents read(const char* path, uint64_t totalItems)
+    {
+        std::ifstream is(path);
+        std::ostringstream os;
+        os << is.rdbuf();
+        const std::string text = os.str();
+        const std::string where = "Journal " + std::string(path);
+
+        auto invalid = [&where](const std::string& what) {
+            return std::runtime_error(where + ": " + what);
+        };
+
+        Contents res;
+        bool header = true;
+
+        for (std::size_t pos = 0, eol; (eol = text.find('\n', pos))
+                                        != std::string::npos; pos = eol + 1)
+        {
+            std::istringstream ls(text.substr(pos, eol - pos));
+            res.bytes = eol + 1;
+
+            if (header)
+            {
+                std::string word;
+                uint64_t total;
+
+                if (!(ls >> word >> total) || word != "total"
+                    || total != totalItems)
+                    throw invalid("belongs to other board size");
+
+                header = false;
+                continue;
+            }
+
+            Entry e;
+            if (!(ls >> e.range.first >> e.range.second >> e.subtotal)
+                || e.range.first >= e.range.second
+                || e.range.second > totalItems)
+                throw invalid("invalid entry \"" + ls.str() + '"');
+
+            res.entries.push_back(e);
+        }
+
+        if (header)
+            throw invalid("is missing or empty");
+
+        std::vector<Range> ranges;
+        for (const Entry& e: res.entries)
+            ranges.push_back(e.range);
+
+        std::ranges::sort(ranges);
+
+        for (std::size_t i = 1; i < ranges.size(); ++i)
+        {
+            if (ranges[i].first < ranges[i - 1].second)
+                throw invalid("work items "
+                              + std::to_string(ranges[i].first) + ".."
+                              + std::to_string(ranges[i - 1].second)
+                              + " are journaled twice");
+        }
+
+        return res;
+    }
+
+private:
+    struct Pending
+    {
+        uint64_t subtotal = 0;
+        std::ptrdiff_t arrived = 0;
+    };
+
+    void append(const std::string& line)
+    {
+        if (write(fd_, line.data(), line.size())
+                != static_cast<ssize_t>(line.size()) || fsync(fd_) != 0)
+            fail("Cannot write journal");
+    }
+
+    [[noreturn]] static void fail(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    static constexpr uint64_t maxUnits = 4096;
+
+    uint64_t unitSize_;
+    Contents resumed_;
+    int fd_;
+    std::mutex mutex_;
+    std::map<Range, Pending> pending_;
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,106 @@
+#include "journal.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+class JournalTest: public testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        std::remove(path.c_str());
+    }
+
+    std::string contents() const
+    {
+        std::ifstream is(path);
+        std::ostringstream os;
+        os << is.rdbuf();
+        return os.str();
+    }
+
+    void write(const std::string& text) const
+    {
+        std::ofstream(path) << text;
+    }
+
+    std::string path = "/tmp/nqueens-journal-" + std::to_string(getpid());
+};
+
+// A line is written when every thread of a team has added its share
+TEST_F(JournalTest, TeamShares)
+{
+    {
+        Journal journal(path.c_str(), 100000, false);
+        EXPECT_EQ(journal.unitEnd(0), 25u);
+        EXPECT_EQ(journal.unitEnd(30), 50u);
+
+        journal.add({0, 25}, 3, 2);
+        journal.add({25, 40}, 7, 1);
+        EXPECT_EQ(Journal::read(path.c_str(), 100000).entries.size(), 1u);
+        journal.add({0, 25}, 4, 2);
+    }
+
+    const Journal::Contents c = Journal::read(path.c_str(), 100000);
+    ASSERT_EQ(c.entries.size(), 2u);
+    EXPECT_EQ(c.entries[0].range, (Journal::Range(25, 40)));
+    EXPECT_EQ(c.entries[0].subtotal, 7u);
+    EXPECT_EQ(c.entries[1].range, (Journal::Range(0, 25)));
+    EXPECT_EQ(c.entries[1].subtotal, 7u);
+}
+
+// New journal replaces the old one
+TEST_F(JournalTest, Restart)
+{
+    write("total 5\n0 5 1\n");
+    {
+        Journal journal(path.c_str(), 10, false);
+        journal.add({0, 5}, 11, 1);
+    }
+
+    EXPECT_EQ(contents(), "total 10\n0 5 11\n");
+}
+
+// Incomplete last line is cut off before new lines are appended
+TEST_F(JournalTest, TornLine)
+{
+    write("total 300\n0 100 5\n228 24");
+    {
+        Journal journal(path.c_str(), 300, true);
+        ASSERT_EQ(journal.resumed().entries.size(), 1u);
+        EXPECT_EQ(journal.resumed().entries[0].subtotal, 5u);
+        journal.add({228, 240}, 32, 1);
+    }
+
+    EXPECT_EQ(contents(), "total 300\n0 100 5\n228 240 32\n");
+
+    Journal journal(path.c_str(), 300, true);
+    EXPECT_EQ(journal.resumed().entries.size(), 2u);
+}
+
+TEST_F(JournalTest, Invalid)
+{
+    EXPECT_THROW(Journal::read(path.c_str(), 10), std::runtime_error);
+
+    for (const char* text: {"total 11\n",       // other size
+                            "total 10\n0 5\n",  // malformed
+                            "total 10\n5 5 1\n",
+                            "total 10\n5 11 1\n",
+                            "total 10\n0 5 1\n3 8 1\n", // overlapping
+                            "total 10\n0 5 1\n0 5 1\n"})
+    {
+        write(text);
+        EXPECT_THROW(Journal::read(path.c_str(), 10), std::runtime_error)
+                << text;
+    }
+
+    write("total 10\n0 5 1\n5 10 2\n");
+    EXPECT_EQ(Journal::read(path.c_str(), 10).entries.size(), 2u);
+}
@@ -0,0 +1,384 @@
+#ifndef LAZYSUBSQUARE_H
+#define LAZYSUBSQUARE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "foreach2.h"
+#include "memstat.h"
+#include "pack.h"
+#include "qdiags.h"
+#include "qgenerator.h"
+#include "scheduler.h"
+
+/* Memory-bounded alternative to Subsquare (without symmetries). Instead
+ * of generating the whole table in constructor, lists of partial solutions
+ * for a single set of rows are generated (with backtracking algorithm) when
+ * withRows() asks for them. Recently used sets of rows are kept in LRU cache
+ * while total size of cached lists does not exceed "budget" bytes. This
+ * trades recomputation for the ability to handle quarter-boards whose
+ * complete table does not fit in memory.
+ *
+ * Interface is the same as Subsquare's (except forRowPieces). CellInd refers
+ * to lists owned by its CellFactory, so it is valid only while the factory
+ * exists. Lists are generated (outside of the lock) by the thread that needs
+ * them first; other threads needing the same lists wait for it, threads
+ * needing other lists generate them at the same time.
+ *
+ * Constructor's "budget" is approximate limit for memory used by cached lists
+ * (in bytes); lists in use are not freed even if this limit is exceeded.
+ *
+ * Template parameters:
+ * size - size of the quarter-board
+ * Storage - a class controlling how sets of diagonals are stored
+ *            (see qdiags.h)
+ */
+template <int size, template<int> class Storage = DiagsPlain>
+class LazySubsquare
+{
+    using Pack = PackIter<size>;
+    using Store = Storage<size>;
+    using Word = Store::Word;
+    using Diagonals = std::array<uint32_t, 2>;
+    using Masks = std::array<Diagonals, 2>;
+    template<class T>
+    using Vector = std::vector<T, CountedAllocator<T, MemUse::quarter>>;
+
+    // Lists for a single set of rows (indexed by set of columns)
+    struct Block
+    {
+        std::size_t bytes() const
+        {
+            return index.size() * sizeof(uint32_t)
+                   + diags.size() * sizeof(Word);
+        }
+
+        Vector<uint32_t> index;
+        Vector<Word> diags;
+        uint32_t specialBit;
+    };
+
+    using BlockPtr = std::shared_ptr<const Block>;
+    using BlockFuture = std::shared_future<BlockPtr>;
+
+public:
+    struct Cell
+    {
+        uint32_t columns;
+    };
+
+    struct CellInd
+    {
+        const Block* block;
+        uint32_t columns;
+    };
+
+    class CellFactory
+    {
+    public:
+        CellFactory(BlockPtr block, uint32_t rows)
+            : block_{std::move(block)}
+            , rows_{rows}
+        {}
+
+        CellInd makeCellInd(uint32_t columns) const
+        {
+            return {block_.get(), columns};
+        }
+
+        CellInd makeCellInd(const Cell& cell) const
+        {
+            return makeCellInd(cell.columns);
+        }
+
+        uint32_t getRows() const
+        {
+            return rows_;
+        }
+
+        const Block& getBlock() const
+        {
+            return *block_;
+        }
+
+    private:
+        BlockPtr block_;
+        uint32_t rows_;
+    };
+
+    // Nothing is generated here, so the number of threads is not used.
+    LazySubsquare(std::ptrdiff_t, std::size_t budget)
+        : budget_{budget}
+    {}
+
+    // Prepare rows info (and lists) to be used in forCells().
+    CellFactory withRows(uint32_t rows) const
+    {
+        return CellFactory(getBlock(rows), rows);
+    }
+
+    // Iterate all non-empty cells for given set of rows.
+    void forCells(const CellFactory& cf, const auto& action) const
+    {
+        const auto& index = cf.getBlock().index;
+
+        Pack::forColumns({0}, cf.getRows(), [&](uint32_t, uint32_t columns) {
+            if (index[columns] != index[columns + 1])
+                action(Cell{columns});
+        });
+    }
+
+    /* Iterate all pairs (cartesian product) of diagonals for given pair
+     * of cells.
+     */
+    template<bool filterDiags, bool other>
+    void forDiags(const CellInd& first,
+                  const CellInd& second,
+                  const auto& action) const
+    {
+        forDiagsImpl<filterDiags, other, false>(first, second, nullptr, action);
+    }
+
+    // Same as above, but skip diagonals intersecting masks (see Subsquare).
+    template<bool filterDiags, bool other>
+    void forDiags(const CellInd& first,
+                  const CellInd& second,
+                  const Masks& masks,
+                  const auto& action) const
+    {
+        forDiagsImpl<filterDiags, other, true>(first, second, masks.data(),
+                                               action);
+    }
+
+    // Number of partial solutions in the list for given cell
+    std::size_t listSize(const CellInd& ci) const
+    {
+        const uint32_t* ix = &ci.block->index[ci.columns];
+        return ix[1] - ix[0];
+    }
+
+    /* Marks a bit so that we will ignore any results having non-zero diagonal
+     * associated with this bit. Cached lists are dropped (they are
+     * partitioned for previous bit).
+     */
+    void setSBit(int bitPos)
+    {
+        ThreadPolicy::Lock lk(mutex_);
+
+        if (specialBit_ == uint32_t{1} << bitPos)
+            return;
+
+        specialBit_ = uint32_t{1} << bitPos;
+        cached_.clear();
+        lru_.clear();
+        cachedBytes_ = 0;
+    }
+
+    // Same as above, but called by several threads at once (see Subsquare).
+    void setSBit(int bitPos, const auto& accepted, const auto& sync)
+    {
+        if (specialBit_ == uint32_t{1} << bitPos)
+            return;
+
+        sync(); // every thread has seen old specialBit_
+
+        if (accepted())
+            setSBit(bitPos);
+
+        sync(); // every thread sees new specialBit_
+    }
+
+    // Return special bit to its initial position (center)
+    void resetSBit()
+    {
+        setSBit(size - 1);
+    }
+
+    // Indicates that no additional check is needed for special bit.
+    static bool handlesSpecialBit()
+    {
+        return true;
+    }
+
+    // Total size of cached lists (for tests and diagnostics)
+    std::size_t cachedBytes() const
+    {
+        ThreadPolicy::Lock lk(mutex_);
+        return cachedBytes_;
+    }
+
+private:
+    static constexpr uint32_t rcCnt_ = 1 << size;
+
+    template<bool filter, bool other, bool masked>
+    void forDiagsImpl(const CellInd& first,
+                      const auto& second,
+                      const Diagonals* mask,
+                      const auto& action) const
+    {
+        auto next = [&, this](const Word& w) {
+            const Diagonals d = Store::load(w);
+
+            if (masked && ((d[0] & (*mask)[0]) | (d[1] & (*mask)[1])))
+                return;
+
+            forDiagsImpl<filter, !other, masked>(second, d, mask + 1, action);
+        };
+
+        namespace r = std::ranges;
+        namespace v = std::views;
+        const Block& block = *first.block;
+        const uint32_t* ix = &block.index[first.columns];
+        auto list = r::subrange(&block.diags[ix[0]], &block.diags[ix[1]]);
+        auto zeroBit = [&block](int whichDiag) {
+            return hasZeroBit<Store>(whichDiag, block.specialBit);
+        };
+
+        if (!filter)
+        {
+            r::for_each(list, next);
+        }
+        else if (other)
+        {
+            forEach2(list | v::take_while(zeroBit(1)),
+                     list | v::reverse | v::take_while(zeroBit(1)),
+                     list.size(),
+                     next);
+        }
+        else
+        {
+            r::for_each(list | v::take_while(zeroBit(0)), next);
+        }
+    }
+
+    template<bool, bool, bool>
+    void forDiagsImpl(const Diagonals& first,
+                      const Diagonals& second,
+                      const Diagonals*,
+                      const auto& action) const
+    {
+        action(std::make_pair(first, second));
+    }
+
+    /* Find lists for given rows in cache or generate them. Rows being
+     * generated are marked in "building_", so that other threads wait
+     * for these lists instead of generating them again.
+     */
+    BlockPtr getBlock(uint32_t rows) const
+    {
+        std::promise<BlockPtr> made;
+        BlockFuture pending;
+        uint32_t specialBit;
+
+        {
+            ThreadPolicy::Lock lk(mutex_);
+
+            if (auto it = cached_.find(rows); it != cached_.end())
+            {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return it->second->second;
+            }
+
+            if (auto it = building_.find(rows); it != building_.end())
+                pending = it->second;
+            else
+                building_.emplace(rows, made.get_future().share());
+
+            specialBit = specialBit_;
+        }
+
+        if (pending.valid())
+            return pending.get();
+
+        BlockPtr block;
+
+        try
+        {
+            block = makeBlock(rows, specialBit);
+        }
+        catch (...)
+        {
+            ThreadPolicy::Lock lk(mutex_);
+            building_.erase(rows);
+            made.set_exception(std::current_exception());
+            throw;
+        }
+
+        ThreadPolicy::Lock lk(mutex_);
+        building_.erase(rows);
+        made.set_value(block);
+        lru_.emplace_front(rows, block);
+        cached_.emplace(rows, lru_.begin());
+        cachedBytes_ += block->bytes();
+
+        while (cachedBytes_ > budget_ && lru_.size() > 1)
+        {
+            cachedBytes_ -= lru_.back().second->bytes();
+            cached_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+
+        return block;
+    }
+
+    // Generate all partial solutions having queens exactly in given rows.
+    static BlockPtr makeBlock(uint32_t rows, uint32_t specialBit)
+    {
+        std::vector<std::pair<uint32_t, Word>> pieces;
+
+        QBacktrack<size>::placeQueens(Board<size>{}, 0, size, rows, size,
+                                      [&](const Board<size>& board) {
+            pieces.emplace_back(board.columns(),
+                                Store::store({board.diags(0), board.diags(1)}));
+        });
+
+        auto block = std::make_shared<Block>();
+        block->index.assign(rcCnt_ + 1, 0);
+        block->diags.resize(pieces.size());
+        block->specialBit = specialBit;
+
+        for (const auto& piece: pieces)
+            ++block->index[piece.first + 1];
+
+        std::partial_sum(block->index.begin(), block->index.end(),
+                         block->index.begin());
+        std::vector<uint32_t> pos(block->index.begin(), block->index.end());
+
+        for (const auto& [columns, word]: pieces)
+            block->diags[pos[columns]++] = word;
+
+        for (uint32_t columns = 0; columns != rcCnt_; ++columns)
+        {
+            partitionDiags<Store>(
+                        std::ranges::subrange(
+                            block->diags.begin() + block->index[columns],
+                            block->diags.begin() + block->index[columns + 1]),
+                        specialBit);
+        }
+
+        return block;
+    }
+
+    using Lru = std::list<std::pair<uint32_t, BlockPtr>>;
+
+    mutable ThreadPolicy::Mutex mutex_;
+    mutable Lru lru_; // most recently used first
+    mutable std::unordered_map<uint32_t, typename Lru::iterator> cached_;
+    mutable std::unordered_map<uint32_t, BlockFuture> building_;
+    mutable std::size_t cachedBytes_ = 0;
+    std::size_t budget_;
+    uint32_t specialBit_ = uint32_t{1} << (size - 1);
+};
+
+#endif // LAZYSUBSQUARE_H
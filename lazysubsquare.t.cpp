@@ -0,0 +1,123 @@
+#include "lazysubsquare.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pack.h"
+#include "qsymmetry.h"
+#include "scheduler.h"
+#include "subsquare.h"
+
+namespace r = std::ranges;
+
+namespace {
+using D2 = std::array<uint32_t, 2>;
+using D4 = std::pair<D2, D2>;
+
+// All pairs for given sets of rows (and all sets of columns), sorted
+template<bool filter, bool other>
+std::vector<D4> collectPairs(const auto& q, uint32_t rows1, uint32_t rows2)
+{
+    std::vector<D4> res;
+    const auto first = q.withRows(rows1);
+    const auto second = q.withRows(rows2);
+
+    q.forCells(first, [&](const auto& cell) {
+        const auto columns = cell.columns ^ 0x3F;
+        q.template forDiags<filter, other>(first.makeCellInd(cell),
+                                           second.makeCellInd(columns),
+                                           [&](const auto& d) {
+            res.push_back(d);
+        });
+    });
+
+    r::sort(res);
+    return res;
+}
+}
+
+TEST(LazySubsquareTest, SameAsSubsquare)
+{
+    static constexpr int size = 6;
+    Subsquare<size, QNoSymmetry, PackIter> full;
+    LazySubsquare<size> lazy(1, 1000); // only a few blocks fit
+
+    for (int bit: {5, 2})
+    {
+        full.setSBit(bit);
+        lazy.setSBit(bit);
+
+        for (uint32_t rows = 0; rows != 64; ++rows)
+        {
+            const uint32_t rows2 = rows ^ 0x2D;
+            EXPECT_EQ((collectPairs<false, false>(lazy, rows, rows2)),
+                      (collectPairs<false, false>(full, rows, rows2)));
+            EXPECT_EQ((collectPairs<true, false>(lazy, rows, rows2)),
+                      (collectPairs<true, false>(full, rows, rows2)));
+            EXPECT_EQ((collectPairs<true, true>(lazy, rows, rows2)),
+                      (collectPairs<true, true>(full, rows, rows2)));
+        }
+    }
+}
+
+TEST(LazySubsquareTest, Budget)
+{
+    static constexpr int size = 6;
+    static constexpr std::size_t budget = 4000;
+    const Subsquare<size, QNoSymmetry, PackIter> full;
+    const LazySubsquare<size> lazy(1, budget);
+    const auto emptyRows = lazy.withRows(0);
+    std::vector<D2> fullList;
+    std::vector<D2> lazyList;
+
+    for (uint32_t rows = 0; rows != 64; ++rows)
+    {
+        const auto factory = lazy.withRows(rows);
+        const auto empty = emptyRows.makeCellInd(0u);
+
+        lazy.forCells(factory, [&](const auto& cell) {
+            lazy.forDiags<false, true>(factory.makeCellInd(cell), empty,
+                                       [&](const auto& d) {
+                lazyList.push_back(d.first);
+            });
+        });
+
+        full.forRowPieces(rows, [&](uint32_t, const auto& d) {
+            fullList.push_back(d);
+        });
+
+        EXPECT_LE(lazy.cachedBytes(), budget);
+    }
+
+    r::sort(fullList);
+    r::sort(lazyList);
+    EXPECT_EQ(lazyList, fullList);
+}
+
+// Threads generating the same or different lists at once
+TEST(LazySubsquareTest, Threads)
+{
+    static constexpr int size = 6;
+    const Subsquare<size, QNoSymmetry, PackIter> full;
+    const LazySubsquare<size> lazy(4, 1000000);
+    Scheduler sch(4);
+
+    const uint64_t mismatches = sch.launch([&](auto&) {
+        uint64_t res = 0;
+
+        for (uint32_t rows = 0; rows != 64; ++rows)
+        {
+            const uint32_t rows2 = rows ^ 0x2D;
+            res += (collectPairs<true, true>(lazy, rows, rows2)
+                    != collectPairs<true, true>(full, rows, rows2));
+        }
+
+        return res;
+    });
+
+    EXPECT_EQ(mismatches, 0u);
+}
@@ -1,14 +1,279 @@
+#include <algorithm>
 #include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
+#include <unistd.h>
+
+#include "coordinator.h"
+#include "journal.h"
+#include "memstat.h"
 #include "solcounter.h"
+#include "workplan.h"
+
+// Parse comma-separated list of board sizes, return empty list on error
+std::vector<int> parseSizes(const char* list)
+{
+    std::vector<int> sizes;
+    std::istringstream is(list);
+
+    for (std::string item; std::getline(is, item, ','); )
+    {
+        const int n = std::atoi(item.c_str());
+        if (n < minBatchSize || n > maxBatchSize)
+            return {};
+        sizes.push_back(n);
+    }
+
+    return sizes;
+}
+
+// Parse amount of memory like "512M" or "16G", return zero on error
+std::size_t parseBytes(const char* str)
+{
+    char* end;
+    const std::size_t value = std::strtoull(str, &end, 10);
+
+    for (std::size_t shift = 0; const char* unit: {"", "K", "M", "G", "T"})
+    {
+        if (std::strcmp(end, unit) == 0)
+            return value << shift;
+        shift += 10;
+    }
+
+    return 0;
+}
+
+// Parse range of work items like "100:200", return false on error
+bool parseRange(const std::string& str, Divider::Range& range)
+{
+    const char* begin = str.c_str();
+    char* end;
+    range.first = std::strtoull(begin, &end, 10);
+    if (end == begin || *end != ':')
+        return false;
+
+    const char* lastStr = end + 1;
+    range.second = std::strtoull(lastStr, &end, 10);
+    return end != lastStr && *end == 0 && range.first <= range.second;
+}
+
+// Parse comma-separated list of ranges, return empty list on error
+std::vector<Divider::Range> parseRanges(const char* list)
+{
+    std::vector<Divider::Range> ranges;
+    std::istringstream is(list);
+
+    for (std::string item; std::getline(is, item, ','); )
+    {
+        if (!parseRange(item, ranges.emplace_back()))
+            return {};
+    }
+
+    return ranges;
+}
+
+// Print ranges of work items for each part (as accepted by --range)
+void printPlan(const WorkPlan& plan, int parts)
+{
+    const auto assignment = plan.assign(parts);
+    double total = 0;
+
+    for (const auto& [ranges, cost]: assignment)
+        total += cost;
+
+    for (int p = 0; const auto& [ranges, cost]: assignment)
+    {
+        std::cout << "Part " << p++ << " (" << 100 * cost / total << "%): ";
+
+        for (const char* sep = ""; const auto& [first, last]: ranges)
+        {
+            std::cout << sep << first << ':' << last;
+            sep = ",";
+        }
+
+        std::cout << '\n';
+    }
+}
+
+// Ranges without given ones (both lists sorted, ranges do not overlap)
+std::vector<Divider::Range> exclude(const std::vector<Divider::Range>& ranges,
+                                    const std::vector<Divider::Range>& done)
+{
+    std::vector<Divider::Range> res;
+    auto d = done.begin();
+
+    for (auto [first, last]: ranges)
+    {
+        for (; d != done.end() && d->first < last; ++d)
+        {
+            if (d->second <= first)
+                continue;
+
+            if (d->first > first)
+                res.push_back({first, d->first});
+
+            first = std::min(last, d->second);
+            if (d->second > last)
+                break;
+        }
+
+        if (first < last)
+            res.push_back({first, last});
+    }
+
+    return res;
+}
+
+// Split selected work items into "units" contiguous pieces of similar size
+std::vector<Divider::Range> splitRanges(
+        const std::vector<Divider::Range>& ranges,
+        uint64_t total,
+        int units)
+{
+    uint64_t selected = 0;
+
+    for (const auto& [first, last]: ranges)
+        selected += std::min(last, total) - std::min(first, total);
+
+    const auto unitSize = std::max<uint64_t>(
+                1, (selected + static_cast<uint64_t>(units) - 1)
+                   / static_cast<uint64_t>(units));
+    std::vector<Divider::Range> res;
+
+    for (auto [first, last]: ranges)
+    {
+        for (last = std::min(last, total); first < last; first += unitSize)
+            res.push_back({first, std::min(last, first + unitSize)});
+    }
+
+    return res;
+}
+
+// Journal is synced when interrupted (its lines are already written)
+int journalFd = -1;
+
+extern "C" void onSignal(int sig)
+{
+    if (journalFd >= 0)
+        fsync(journalFd);
+
+    static const char msg[] = "\nInterrupted, journal is saved\n";
+    (void)!write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+// Amount of memory in megabytes (for reports)
+std::size_t mb(std::size_t bytes)
+{
+    return bytes >> 20;
+}
 
 int main(int argc, char* argv[])
 {
     int threads = 4;
     int part = 0;
     int parts = 1;
+    std::vector<Divider::Range> ranges;
+    int planParts = 0;
+    const char* timings = nullptr;
+    const char* journalPath = nullptr;
+    bool resume = false;
+    std::vector<int> sizes;
+    std::size_t memLimit = availableMemory();
+
+    while (argc >= 3 && std::strncmp(argv[1], "--", 2) == 0)
+    {
+        if (std::strcmp(argv[1], "--sizes") == 0)
+        {
+            sizes = parseSizes(argv[2]);
+            if (sizes.empty())
+            {
+                std::cerr << "Sizes should be in range " << minBatchSize
+                          << ".." << maxBatchSize << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[1], "--mem-limit") == 0)
+        {
+            memLimit = parseBytes(argv[2]);
+            if (memLimit == 0)
+            {
+                std::cerr << "Memory limit should look like 512M or 16G\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[1], "--range") == 0)
+        {
+            ranges = parseRanges(argv[2]);
+            if (ranges.empty())
+            {
+                std::cerr << "Range should look like 1000:2000"
+                          << " (or 0:10,20:30 for several ranges)\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[1], "--plan") == 0)
+        {
+            planParts = std::atoi(argv[2]);
+            if (planParts <= 0)
+            {
+                std::cerr << "Number of planned parts should be positive\n";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[1], "--timings") == 0)
+        {
+            timings = argv[2];
+        }
+        else if (std::strcmp(argv[1], "--journal") == 0
+                 || std::strcmp(argv[1], "--resume") == 0)
+        {
+            journalPath = argv[2];
+            resume = argv[1][2] == 'r';
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argv[1] << '\n';
+            return EXIT_FAILURE;
+        }
+
+        argc -= 2;
+        argv += 2;
+    }
+
+    /* Coordinator mode: "coordinate workers [threads [units]]" runs units
+     * of work by local worker processes, each of them with its own threads.
+     */
+    int workers = 0;
+    int units = 0;
+
+    if (argc >= 2 && std::strcmp(argv[1], "coordinate") == 0)
+    {
+        workers = argc >= 3 ? std::atoi(argv[2]) : 0;
+        threads = argc >= 4 ? std::atoi(argv[3]) : 1;
+        units = argc >= 5 ? std::atoi(argv[4]) : 32 * workers;
+
+        if (workers <= 0 || threads <= 0 || units <= 0)
+        {
+            std::cerr << "Usage: nqueens [options] coordinate workers"
+                      << " [threads [units]]\n";
+            return EXIT_FAILURE;
+        }
+
+        argc = 1;
+    }
 
     if (argc >= 2)
         threads = std::atoi(argv[1]);
@@ -19,10 +284,193 @@ int main(int argc, char* argv[])
     if (argc >= 4)
         part = std::atoi(argv[3]);
 
+    if (workers && (!sizes.empty() || planParts || timings))
+    {
+        std::cerr << "Coordinator cannot be used with several sizes, plans"
+                  << " or timings\n";
+        return EXIT_FAILURE;
+    }
+
+    if (!sizes.empty() && (!ranges.empty() || planParts || timings
+                           || journalPath))
+    {
+        std::cerr << "Ranges, plans, timings and journals cannot be used"
+                  << " with several sizes\n";
+        return EXIT_FAILURE;
+    }
+
+    if (journalPath && (planParts || parts != 1))
+    {
+        std::cerr << "Journal cannot be used with plans or parts\n";
+        return EXIT_FAILURE;
+    }
+
+    for (const auto& [first, last]: ranges)
+    {
+        std::cerr << "Work items " << first << ".." << last << " of "
+                  << workItems<size>() << '\n';
+    }
+
+    if (ranges.empty())
+        ranges.push_back({0, Divider::all});
+
+    /* Resumed run skips work items recorded in the journal (and adds their
+     * subtotals to the result), new subtotals are appended to the journal.
+     */
+    uint64_t journaled = 0;
+    std::unique_ptr<Journal> journal;
+
+    if (journalPath)
+    {
+        try
+        {
+            journal = std::make_unique<Journal>(journalPath,
+                                                workItems<size>(), resume);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+
+        journalFd = journal->fd();
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+    }
+
+    if (resume)
+    {
+        std::vector<Divider::Range> done;
+        uint64_t doneItems = 0;
+
+        for (const auto& [range, subtotal]: journal->resumed().entries)
+        {
+            done.push_back(range);
+            doneItems += range.second - range.first;
+            journaled += subtotal;
+        }
+
+        std::ranges::sort(ranges);
+        std::ranges::sort(done);
+        ranges = exclude(ranges, done);
+        std::cerr << "Resuming: " << doneItems << " work items journaled\n";
+    }
+
+    /* Planning run only estimates costs of work items (refined by timings
+     * of earlier runs, if any). Normal run with timings file records them.
+     */
+    std::unique_ptr<WorkPlan> workPlan;
+
+    if (planParts)
+    {
+        workPlan = std::make_unique<WorkPlan>(WorkPlan::Mode::estimate,
+                                              workItems<size>());
+        parts = 1;
+
+        if (timings)
+        {
+            std::ifstream is(timings);
+            if (!is || !workPlan->readTimings(is))
+            {
+                std::cerr << "Cannot read timings from " << timings << '\n';
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    else if (timings)
+    {
+        workPlan = std::make_unique<WorkPlan>(WorkPlan::Mode::record,
+                                              workItems<size>());
+    }
+
+    const Divider div(part, parts, ranges, workPlan.get(), journal.get());
+
+    // Every worker process has its own quarter-board table
+    const MemPlan plan = planMemory(sizes.empty()? std::vector{size}: sizes,
+                                    threads,
+                                    workers ? memLimit / workers : memLimit);
+
+    if (plan.threads == 0)
+    {
+        std::cerr << "Not enough memory: " << mb(plan.required)
+                  << " MB needed, limit is " << mb(memLimit) << " MB\n";
+        return EXIT_FAILURE;
+    }
+
+    if (plan.listsBudget != 0)
+    {
+        std::cerr << "Quarter-board tables do not fit, their lists are"
+                  << " generated on demand (" << mb(plan.listsBudget)
+                  << " MB cache)\n";
+    }
+
+    if (plan.threads < threads)
+    {
+        std::cerr << "Using " << plan.threads << " threads to fit into "
+                  << mb(memLimit) << " MB\n";
+        threads = plan.threads;
+    }
+
     auto startClock = std::chrono::high_resolution_clock::now();
-    auto res = countSolutions(threads, part, parts);
+
+    if (workers)
+    {
+        Coordinator coordinator(splitRanges(ranges, workItems<size>(), units));
+
+        try
+        {
+            auto res = journaled + coordinator.run(workers,
+                    [&](const auto& next, const auto& reply) {
+                countRanges(threads, plan.sieveBudget, plan.listsBudget,
+                            next, reply);
+            }, [&](Divider::Range unit, uint64_t subtotal) {
+                if (journal)
+                    journal->add(unit, subtotal, 1);
+            });
+            std::cout << "Result: " << res << '\n';
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    else if (planParts)
+    {
+        countSolutions(threads, div, plan.sieveBudget, plan.listsBudget);
+        printPlan(*workPlan, planParts);
+    }
+    else if (sizes.empty())
+    {
+        auto res = journaled + countSolutions(threads, div, plan.sieveBudget,
+                                              plan.listsBudget);
+        std::cout << "Result: " << res << '\n';
+
+        if (timings)
+        {
+            std::ofstream os(timings, std::ios::app);
+            workPlan->writeTimings(os);
+            if (!os)
+                std::cerr << "Cannot write timings to " << timings << '\n';
+        }
+    }
+    else
+    {
+        countSolutions(threads, div, plan.sieveBudget,
+                       plan.listsBudget, sizes, [](int n, uint64_t res) {
+            std::cout << "Result for size " << n << ": " << res << std::endl;
+        });
+    }
+
     auto finishClock = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = finishClock - startClock;
-    std::cout << "Result: " << res << '\n';
     std::cout << "Elapsed time: " << elapsed.count() << " s\n";
+
+    if (workers) // memory of worker processes is not known here
+        return EXIT_SUCCESS;
+
+    std::cout << "Peak memory: " << mb(peakRss()) << " MB resident, "
+              << mb(MemStat::peak(MemUse::quarter)) << " MB quarter tables, "
+              << mb(MemStat::peak(MemUse::mapped)) << " MB mapped tables, "
+              << mb(MemStat::peak(MemUse::patterns)) << " MB patterns\n";
 }
@@ -0,0 +1,164 @@
+#ifndef MAPPEDVECTOR_H
+#define MAPPEDVECTOR_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "memstat.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+// Directory for MappedVector's files: NQUEENS_MAP_DIR, TMPDIR, or /tmp
+inline const char* mapDirectory()
+{
+    for (const char* var: {"NQUEENS_MAP_DIR", "TMPDIR"})
+    {
+        if (const char* dir = std::getenv(var))
+            return dir;
+    }
+
+    return "/tmp";
+}
+
+// Free space (in bytes) available for MappedVector's files
+inline std::size_t mapDirSpace()
+{
+    struct statvfs st {};
+
+    if (statvfs(mapDirectory(), &st) != 0)
+        return 0;
+
+    return static_cast<std::size_t>(st.f_bavail) * st.f_frsize;
+}
+
+/* Array of trivially copyable elements stored in a memory mapped temporary
+ * file. The file is unlinked right after creation, so nothing is left on
+ * disk when the program exits. Only the part of std::vector's interface
+ * needed by Subsquare is implemented; new elements are zero-initialized.
+ *
+ * Files are created in directory given by environment variable
+ * NQUEENS_MAP_DIR (or TMPDIR, or /tmp), which should be on a fast local disk.
+ * Linux only.
+ */
+template<class T>
+requires std::is_trivially_copyable_v<T>
+class MappedVector
+{
+public:
+    MappedVector()
+    {
+        std::string path = std::string(mapDirectory()) + "/nqueens-XXXXXX";
+        fd_ = mkstemp(path.data());
+
+        if (fd_ < 0)
+            fail("cannot create file in " + std::string(mapDirectory()));
+
+        unlink(path.c_str());
+    }
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    ~MappedVector()
+    {
+        unmap();
+        close(fd_);
+    }
+
+    void resize(std::size_t count)
+    {
+        unmap();
+
+        if (ftruncate(fd_, static_cast<off_t>(count * sizeof(T))) != 0)
+            fail("cannot resize mapped file");
+
+        if (count != 0)
+        {
+            void* addr = mmap(nullptr, count * sizeof(T),
+                              PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+            if (addr == MAP_FAILED)
+                fail("cannot map file");
+
+            data_ = static_cast<T*>(addr);
+            size_ = count;
+            MemStat::add(MemUse::mapped, size_ * sizeof(T));
+        }
+    }
+
+    // Ask OS to start reading elements [begin, end) in background
+    void willNeed(std::size_t begin, std::size_t end) const
+    {
+        static const std::size_t pageMask = ~(pageSize() - 1);
+        const std::size_t first = (begin * sizeof(T)) & pageMask;
+        const std::size_t last = end * sizeof(T);
+
+        if (last > first)
+        {
+            char* addr = reinterpret_cast<char*>(data_) + first;
+            madvise(addr, last - first, MADV_WILLNEED);
+        }
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    T* data()
+    {
+        return data_;
+    }
+
+    const T* data() const
+    {
+        return data_;
+    }
+
+    T& operator[](std::size_t pos)
+    {
+        return data_[pos];
+    }
+
+    const T& operator[](std::size_t pos) const
+    {
+        return data_[pos];
+    }
+
+private:
+    void unmap()
+    {
+        if (data_)
+        {
+            munmap(data_, size_ * sizeof(T));
+            MemStat::sub(MemUse::mapped, size_ * sizeof(T));
+        }
+
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    static std::size_t pageSize()
+    {
+        return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    [[noreturn]] static void fail(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    int fd_;
+};
+
+#endif // MAPPEDVECTOR_H
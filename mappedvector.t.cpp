@@ -0,0 +1,48 @@
+#include "mappedvector.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <gtest/gtest.h>
+
+TEST(MappedVectorTest, Resize)
+{
+    MappedVector<uint64_t> v;
+    EXPECT_EQ(v.size(), 0u);
+
+    v.resize(1000);
+    ASSERT_EQ(v.size(), 1000u);
+    EXPECT_EQ(v[0], 0u);
+    EXPECT_EQ(v[999], 0u);
+
+    for (uint64_t i = 0; i != v.size(); ++i)
+        v[i] = i * i;
+
+    v.resize(100000); // old contents survive remapping
+    ASSERT_EQ(v.size(), 100000u);
+    EXPECT_EQ(v[999], 999u * 999u);
+    EXPECT_EQ(v.data()[3], 9u);
+    EXPECT_EQ(v[99999], 0u);
+
+    v.willNeed(10, 50000);
+    v.resize(10);
+    EXPECT_EQ(v.size(), 10u);
+    EXPECT_EQ(v[9], 81u);
+}
+
+TEST(MappedVectorTest, MapDirSpace)
+{
+    const char* old = std::getenv("NQUEENS_MAP_DIR");
+    const std::string saved = old ? old : "";
+
+    setenv("NQUEENS_MAP_DIR", "/nonexistent-nqueens-dir", 1);
+    EXPECT_STREQ(mapDirectory(), "/nonexistent-nqueens-dir");
+    EXPECT_EQ(mapDirSpace(), 0u);
+
+    if (old)
+        setenv("NQUEENS_MAP_DIR", saved.c_str(), 1);
+    else
+        unsetenv("NQUEENS_MAP_DIR");
+
+    EXPECT_GT(mapDirSpace(), 0u);
+}
@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "cfg.h"
+#include "memstat.h"
 #include "prefetch.h"
 #include "util.h"
 
@@ -98,6 +99,18 @@ public:
             prefetchL2(&transposed_[0][0][item & chunkMask_]);
     }
 
+    // Number of stored patterns (including padding of transposed ones)
+    size_t patternCount() const
+    {
+        return patterns_.size() + transposed_.size() * patMaxSize_;
+    }
+
+    // Approximate memory needed to store one pattern
+    static constexpr size_t bytesPerPattern()
+    {
+        return sizeof(Piece) / patMaxSize_ + 1;
+    }
+
     // Only for unit tests
     size_t testPatternsSize() const
     {
@@ -123,7 +136,9 @@ private:
     struct alignas(cfg.align) Group: public std::array<uint64_t, groupSize_> {};
     using Chunk = std::array<Group, trChunkSize_>;
     using Piece = std::array<Chunk, numChunks_>;
-    using PieceVec = std::vector<Piece>;
+    template<class T>
+    using Vector = std::vector<T, CountedAllocator<T, MemUse::patterns>>;
+    using PieceVec = Vector<Piece>;
 
     void processPatterns()
     {
@@ -248,7 +263,7 @@ private:
             dst[elem] &= src[elem];
     }
 
-    std::vector<uint64_t> patterns_;
+    Vector<uint64_t> patterns_;
     PieceVec transposed_;
 };
 
@@ -0,0 +1,146 @@
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+/* Memory accounting. Large containers use CountedAllocator (or update
+ * counters directly, as MappedVector does), so that the number of bytes
+ * currently allocated for each kind of data and its peak value are known
+ * at any moment. Counters are updated only when containers grow or shrink,
+ * which is rare enough to use atomics.
+ *
+ * Also contains functions reporting peak resident set size of the process
+ * and memory available to it (cgroup limit or physical memory).
+ */
+enum class MemUse
+{
+    quarter,  // quarter-board tables in memory (Subsquare, LazySubsquare)
+    mapped,   // quarter-board tables in memory mapped files
+    patterns, // half-board patterns (Sieve's matchers: thread-local and frozen)
+    count_
+};
+
+class MemStat
+{
+public:
+    static void add(MemUse use, std::size_t bytes)
+    {
+        auto& c = counters_[index(use)];
+        const std::size_t now = c.current.fetch_add(bytes) + bytes;
+        std::size_t peak = c.peak.load();
+
+        while (now > peak && !c.peak.compare_exchange_weak(peak, now))
+        {}
+    }
+
+    static void sub(MemUse use, std::size_t bytes)
+    {
+        counters_[index(use)].current.fetch_sub(bytes);
+    }
+
+    static std::size_t current(MemUse use)
+    {
+        return counters_[index(use)].current.load();
+    }
+
+    static std::size_t peak(MemUse use)
+    {
+        return counters_[index(use)].peak.load();
+    }
+
+private:
+    struct Counter // value-initialized (zero)
+    {
+        std::atomic<std::size_t> current;
+        std::atomic<std::size_t> peak;
+    };
+
+    static constexpr std::size_t index(MemUse use)
+    {
+        return static_cast<std::size_t>(use);
+    }
+
+    static constexpr auto useCnt_ = static_cast<std::size_t>(MemUse::count_);
+    static inline std::array<Counter, useCnt_> counters_;
+};
+
+// Allocator (for standard containers) that updates MemStat
+template<class T, MemUse use>
+struct CountedAllocator: std::allocator<T>
+{
+    using value_type = T;
+
+    template<class U>
+    struct rebind
+    {
+        using other = CountedAllocator<U, use>;
+    };
+
+    CountedAllocator() = default;
+
+    template<class U>
+    CountedAllocator(const CountedAllocator<U, use>&)
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        T* p = std::allocator<T>::allocate(n);
+        MemStat::add(use, n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        MemStat::sub(use, n * sizeof(T));
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+template<class T, class U, MemUse use>
+bool operator==(const CountedAllocator<T, use>&,
+                const CountedAllocator<U, use>&)
+{
+    return true;
+}
+
+// Peak resident set size of this process (in bytes)
+inline std::size_t peakRss()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // Linux: in KB
+}
+
+/* Memory available to this process: cgroup limit (v2 or v1) if it is set,
+ * otherwise the size of physical memory. Linux only.
+ */
+inline std::size_t availableMemory()
+{
+    const auto pages = static_cast<std::size_t>(sysconf(_SC_PHYS_PAGES));
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t limit = pages * pageSize;
+
+    for (const char* path: {"/sys/fs/cgroup/memory.max",
+                            "/sys/fs/cgroup/memory/memory.limit_in_bytes"})
+    {
+        std::ifstream is(path);
+        std::string value;
+
+        if (is >> value && value != "max")
+            limit = std::min<std::size_t>(limit, std::stoull(value));
+    }
+
+    return limit;
+}
+
+#endif // MEMSTAT_H
@@ -0,0 +1,48 @@
+#include "memstat.h"
+
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "mappedvector.h"
+
+TEST(MemStatTest, CountedAllocator)
+{
+    using Vec = std::vector<uint64_t,
+                            CountedAllocator<uint64_t, MemUse::patterns>>;
+    const std::size_t before = MemStat::current(MemUse::patterns);
+
+    {
+        Vec v(1000);
+        EXPECT_EQ(MemStat::current(MemUse::patterns), before + 8000);
+
+        v.clear();
+        v.shrink_to_fit();
+        EXPECT_EQ(MemStat::current(MemUse::patterns), before);
+    }
+
+    EXPECT_EQ(MemStat::current(MemUse::patterns), before);
+    EXPECT_GE(MemStat::peak(MemUse::patterns), before + 8000);
+}
+
+TEST(MemStatTest, MappedVector)
+{
+    const std::size_t before = MemStat::current(MemUse::mapped);
+
+    {
+        MappedVector<uint32_t> v;
+        v.resize(1000);
+        EXPECT_EQ(MemStat::current(MemUse::mapped), before + 4000);
+
+        v.resize(10);
+        EXPECT_EQ(MemStat::current(MemUse::mapped), before + 40);
+    }
+
+    EXPECT_EQ(MemStat::current(MemUse::mapped), before);
+}
+
+TEST(MemStatTest, System)
+{
+    EXPECT_GT(peakRss(), 0u);
+    EXPECT_GT(availableMemory(), 0u);
+}
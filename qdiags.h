@@ -0,0 +1,126 @@
+/* Contains 3 classes that control how Subsquare stores sets of occupied
+ * diagonals (pairs of bitsets, 2*size-1 significant bits each):
+ * DiagsPlain: two 32-bit words, fastest to access (if table fits in cache)
+ * DiagsPacked: both bitsets packed together into as few bytes as possible
+ *              (4 bytes for size <= 8, 5 bytes for 9..10, 6 bytes for 11..12)
+ * DiagsMapped: same as DiagsPacked, but Subsquare keeps its lists and index
+ *              in memory mapped files (see mappedvector.h), so that tables
+ *              larger than RAM could be used
+ *
+ * Members:
+ * Word - stored representation of a pair of bitsets
+ * store - converts pair of bitsets to Word
+ * load - converts Word to pair of bitsets
+ * Vector - container for Subsquare's lists and index
+ *
+ * Also contains functions for lists of stored diagonals (hasZeroBit,
+ * partitionDiags), used by both Subsquare and LazySubsquare.
+ */
+#ifndef QDIAGS_H
+#define QDIAGS_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <ranges>
+#include <vector>
+
+#include "mappedvector.h"
+#include "memstat.h"
+#include "util.h"
+
+template <int size>
+struct DiagsPlain
+{
+    using Diagonals = std::array<uint32_t, 2>;
+    using Word = Diagonals;
+
+    static Word store(const Diagonals& d)
+    {
+        return d;
+    }
+
+    static Diagonals load(const Word& w)
+    {
+        return w;
+    }
+
+    template<class T>
+    using Vector = std::vector<T, CountedAllocator<T, MemUse::quarter>>;
+};
+
+template <int size>
+requires(size <= 16)
+struct DiagsPacked
+{
+    using Diagonals = std::array<uint32_t, 2>;
+    static constexpr int diagBits_ = 2 * size - 1;
+    static constexpr int bytes_ = (2 * diagBits_ + 7) / 8;
+    using Word = std::array<uint8_t, bytes_>;
+
+    static Word store(const Diagonals& d)
+    {
+        Word w;
+        uint64_t packed = (uint64_t{d[1]} << diagBits_) | d[0];
+
+        for (uint8_t& byte: w)
+        {
+            byte = static_cast<uint8_t>(packed);
+            packed >>= 8;
+        }
+
+        return w;
+    }
+
+    static Diagonals load(const Word& w)
+    {
+        uint64_t packed = 0;
+
+        for (int i = 0; i != bytes_; ++i)
+            packed |= uint64_t{w[i]} << (8 * i);
+
+        return {static_cast<uint32_t>(packed & mask_),
+                static_cast<uint32_t>(packed >> diagBits_)};
+    }
+
+    static constexpr uint64_t mask_ = nLeastBits<uint64_t>(diagBits_);
+
+    template<class T>
+    using Vector = std::vector<T, CountedAllocator<T, MemUse::quarter>>;
+};
+
+template <int size>
+struct DiagsMapped: DiagsPacked<size>
+{
+    template<class T>
+    using Vector = MappedVector<T>;
+};
+
+// Predicate for stored diagonals: true if given bit is zero in d[whichDiag]
+template <class Store>
+auto hasZeroBit(int whichDiag, uint32_t bit)
+{
+    return [whichDiag, bit](const Store::Word& w) {
+        const auto d = Store::load(w);
+        return (d[whichDiag] & bit) == 0;
+    };
+}
+
+/* Move elements having nonzero given (special) bit closer to each other:
+ * order by (d0, d1) bits is (0, 0), (0, 1), (1, 1), (1, 0). So elements
+ * with zero bit in d0 are at the beginning, and elements with zero bit
+ * in d1 are at both ends of the list.
+ */
+template <class Store>
+void partitionDiags(auto&& list, uint32_t bit)
+{
+    namespace r = std::ranges;
+
+    auto bit1R = r::partition(list, hasZeroBit<Store>(0, bit));
+    auto bit0R = r::subrange(list.begin(), bit1R.begin());
+    r::partition(bit0R, hasZeroBit<Store>(1, bit));
+    r::partition(bit1R, std::not_fn(hasZeroBit<Store>(1, bit)));
+}
+
+#endif // QDIAGS_H
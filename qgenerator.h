@@ -0,0 +1,140 @@
+/* Contains 2 classes that generate partial solutions for Subsquare:
+ * QBacktrack: places queens row by row with backtracking algorithm
+ * QExtend: extends partial solutions of the quarter-board one row/column
+ *          smaller (taken from existing Subsquare)
+ *
+ * Members:
+ * taskCnt - number of tasks; every task produces solutions for its own
+ *           sets of rows, so that different tasks may run in parallel
+ * forTask - calls action(board) for each partial solution of given task;
+ *           repeated calls produce solutions in the same order
+ */
+#ifndef QGENERATOR_H
+#define QGENERATOR_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "board.h"
+#include "util.h"
+
+template <int size>
+class QBacktrack
+{
+    static constexpr int prefixRows_ = std::min(size - 1, 6);
+
+public:
+    static constexpr uint32_t taskCnt = uint32_t{1} << prefixRows_;
+
+    /* Occupation of first prefixRows_ rows is fixed by bits of task number,
+     * so each task produces solutions for different sets of rows.
+     */
+    void forTask(uint32_t task, const auto& action) const
+    {
+        placeQueens(Board<size>{}, 0, size, task, prefixRows_, action);
+    }
+
+    /* Recursively place queens to rows [row, endRow). Occupation of rows
+     * below prefixEnd is fixed by bits of "prefix".
+     */
+    static void placeQueens(const Board<size>& board,
+                            const int row,
+                            const int endRow,
+                            const uint32_t prefix,
+                            const int prefixEnd,
+                            const auto& action)
+    {
+        if (row == endRow)
+        {
+            action(board);
+            return;
+        }
+
+        const bool fixed = row < prefixEnd;
+        const bool occupied = (prefix >> row) & 1;
+
+        if (!fixed || occupied)
+        {
+            uint32_t columns = board.getFreeColumns(row);
+
+            while (columns != 0)
+            {
+                uint32_t firstBit = columns & -columns;
+                placeQueens(board.addQueen(row, firstBit), row + 1, endRow,
+                            prefix, prefixEnd, action);
+                columns ^= firstBit;
+            }
+        }
+
+        if (!fixed || !occupied) // empty row
+            placeQueens(board, row + 1, endRow, prefix, prefixEnd, action);
+    }
+};
+
+/* Every solution for quarter-board of given size consists of a solution for
+ * the board one row/column smaller and 0..2 queens in the new (last) row and
+ * column. Diagonals of smaller solution are adjusted to larger board: d0 is
+ * shifted by one, d1 is unchanged. Each task corresponds to a single set
+ * of rows. Source is usually a Subsquare without symmetries.
+ */
+template <int size, class Source>
+class QExtend
+{
+    static constexpr int last_ = size - 1;
+    static constexpr uint32_t lastBit_ = uint32_t{1} << last_;
+
+public:
+    static constexpr uint32_t taskCnt = uint32_t{1} << size;
+
+    explicit QExtend(const Source& source)
+        : source_{source}
+    {}
+
+    void forTask(uint32_t rows, const auto& action) const
+    {
+        const uint32_t oldRows = rows & ~lastBit_;
+        const bool lastRow = rows & lastBit_;
+
+        // last column is empty or occupied by the corner queen
+        extend(oldRows, 0, lastRow, action);
+
+        // last column is occupied in one of old rows
+        for (uint32_t r = oldRows; r; r &= r - 1)
+            extend(oldRows ^ (r & -r), r & -r, lastRow, action);
+    }
+
+private:
+    void extend(const uint32_t srcRows,
+                const uint32_t columnQueen, // row of last column's queen
+                const bool lastRow,
+                const auto& action) const
+    {
+        const int queenRow = std::countr_zero(columnQueen);
+
+        source_.forRowPieces(srcRows, [&](uint32_t columns, const auto& d) {
+            auto board = Board<size>::occupied(srcRows, columns,
+                                               d[0] << 1, d[1]);
+            if (columnQueen)
+            {
+                if ((board.getFreeColumns(queenRow) & lastBit_) == 0)
+                    return;
+
+                board = board.addQueen(queenRow, lastBit_);
+            }
+
+            if (!lastRow)
+            {
+                action(board);
+                return;
+            }
+
+            for (uint32_t c = board.getFreeColumns(last_); c; c &= c - 1)
+                action(board.addQueen(last_, c & -c));
+        });
+    }
+
+    const Source& source_;
+};
+
+#endif // QGENERATOR_H
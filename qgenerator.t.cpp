@@ -0,0 +1,50 @@
+#include "qgenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "pack.h"
+#include "qsymmetry.h"
+#include "subsquare.h"
+
+namespace {
+using Piece = std::array<uint32_t, 4>;
+
+// Collect all solutions, check that different tasks use different rows
+template<class Gen>
+std::vector<Piece> collect(const Gen& gen = {})
+{
+    std::vector<Piece> pieces;
+    std::vector<uint32_t> taskOfRows(1 << 8, Gen::taskCnt);
+
+    for (uint32_t task = 0; task != Gen::taskCnt; ++task)
+    {
+        gen.forTask(task, [&](const auto& b) {
+            pieces.push_back({b.rows(), b.columns(), b.diags(0), b.diags(1)});
+
+            if (taskOfRows[b.rows()] == Gen::taskCnt)
+                taskOfRows[b.rows()] = task;
+
+            EXPECT_EQ(taskOfRows[b.rows()], task);
+        });
+    }
+
+    return pieces;
+}
+}
+
+TEST(QGeneratorTest, Extend)
+{
+    static constexpr int size = 7;
+    using Source = Subsquare<size - 1, QNoSymmetry, PackIter>;
+    const Source source;
+    auto backtrack = collect<QBacktrack<size>>();
+    auto extend = collect(QExtend<size, Source>{source});
+
+    std::ranges::sort(backtrack);
+    std::ranges::sort(extend);
+    EXPECT_EQ(backtrack, extend);
+}
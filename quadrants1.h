@@ -4,13 +4,21 @@
 #ifndef QUADRANTS1_H
 #define QUADRANTS1_H
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <utility>
 
+#include "bitcombsymm.h"
 #include "divider.h"
 #include "freeze.h"
+#include "journal.h"
 #include "scheduler.h"
 #include "util.h"
+#include "workplan.h"
 
 /* Context Object pattern. Represents information and services needed for
  * main algorithm.
@@ -45,7 +53,8 @@ struct Context
  * OEIS A000170 sequence). Unlike other approaches, this algorithm does
  * not use backtracking (directly). Instead it splits the chessboard
  * into four quadrants, generates all possible solutions for each quadrant
- * (stored in member quarter_), joins 'north' and 'south' parts of each
+ * (stored in member quarter_, which may be shared with other instances
+ * of this class), joins 'north' and 'south' parts of each
  * ('east' and 'west') halfboard, and finally counts all cases where these
  * halfboards match each other (do not have queens competing for same diagonal).
  *
@@ -59,7 +68,9 @@ struct Context
  * placement. For even sizes we choose unique row combinations
  * (for north-south symmetry) and then try one of the following: filter out
  * redundant half-solutions based on longest diagonals occupation
- * (for other two symmetries) or use east-west symmetry.
+ * (for other two symmetries), compare rows and columns of the quarter
+ * holding the only occupied longest diagonal (for reflection in this
+ * diagonal) or use east-west symmetry.
  *
  * Main entry point (operator()) could be entered by several threads at once.
  * Then small part of work is duplicated by all threads until
@@ -71,7 +82,8 @@ struct Context
  * sets barriers that divide different steps of computation and allow to use
  * this shared mutable data either as shared immutable or as unshared mutable
  * at different steps. Unlike other methods, constructor/destructor are
- * single-threaded.
+ * not entered by several threads (though constructor may start its own
+ * threads to build quarter_).
  *
  * env.start object controls many details of this class' behavoir. It determines
  * where one or two initial queens are located (for odd sizes). Also it commands
@@ -90,6 +102,15 @@ requires(size > 4)
 class Quadrants1
 {
 public:
+    Quadrants1()
+        : quarter_(std::make_shared<Quarter>())
+    {}
+
+    // Use existing quarter (which may serve several board sizes)
+    explicit Quadrants1(std::shared_ptr<Quarter> quarter)
+        : quarter_(std::move(quarter))
+    {}
+
     uint64_t operator() (auto& env) const
     {
         return doWhole(env);
@@ -97,11 +118,15 @@ public:
 
     /* Marks a bit to west of the center so that quarter_ will not produce
      * any partial results having non-zero diagonal associated with this bit.
+     * Repartitioning of quarter_'s lists is shared by all threads.
      */
     void setSBit(auto& env, int bitPos)
     {
-        if (env.thread->accepted())
-            quarter_.setSBit(bitPos);
+        env.sync(); // quarter_ is not used by other threads
+
+        quarter_->setSBit(bitPos,
+                          [&] { return env.thread->accepted(); },
+                          [&] { env.sync(); });
     }
 
     /* Frees memory that is still allocated by some containers. (These
@@ -120,108 +145,297 @@ private:
     {
         unsigned prim;
         unsigned sec;
-        explicit operator bool () const { return prim; }
+    };
+
+    // Sets of columns of north and south cells (quarters) of a half-board
+    struct CellColumns
+    {
+        uint32_t north;
+        uint32_t south;
     };
 
     /* For each row, set queen to east/west side of the board, then process
      * east/west halfboards and update number of solutions accordingly.
      */
     uint64_t doWhole(auto& env) const
+    {
+        const auto combs = env.start.getBitComb();
+        WorkPlan* plan = env.divider.plan();
+
+        return forClaimed(env, combs.size(), [&, this](uint64_t first,
+                                                       uint64_t last) {
+            uint64_t counter = 0;
+
+            for (uint64_t next = first;
+                 const auto comb: slice(combs, first, last))
+            {
+                const uint64_t rank = next++;
+                if (env.divider()) continue;
+                const uint32_t eastRows = env.start.stretchRows(combRows(comb));
+                const uint32_t westRows = eastRows ^ env.start.getFreeRows();
+                const Symm m = getRowsSymm(comb);
+
+                auto process = [&, this] {
+                    if (fillWest(env, eastRows, westRows))
+                        return m.prim * doPasses<true>(env, westRows, eastRows,
+                                                       m.sec);
+                    else
+                        return m.prim * doPasses<false>(env, eastRows, westRows,
+                                                        m.sec);
+                };
+
+                // Plain containers (tests) are never planned
+                if constexpr (requires { combs.rank(comb); })
+                {
+                    if (plan) [[unlikely]]
+                    {
+                        auto cost = [&, this] {
+                            return static_cast<double>(
+                                        estimate<false>(env, eastRows))
+                                 * static_cast<double>(
+                                        estimate<true>(env, westRows));
+                        };
+
+                        counter += planItem(env, *plan, rank, cost, process);
+                        continue;
+                    }
+                }
+
+                counter += process();
+            }
+
+            return counter;
+        });
+    }
+
+    /* Calls process(first, last) for selected ranks of row combinations
+     * (see Divider), returns sum of results. With a journal, these ranks
+     * are split into journal's units, share of this thread in each unit
+     * is journaled (multiplied as the start would multiply it).
+     */
+    uint64_t forClaimed(auto& env, uint64_t count, const auto& process) const
     {
         uint64_t counter = 0;
+        Journal* journal = env.divider.journal();
 
-        for (uint32_t bits: env.start.getBitComb())
-        {
-            if (env.divider()) continue;
-            const uint32_t eastRows = env.start.stretchRows(bits);
-            const uint32_t westRows = eastRows ^ env.start.getFreeRows();
+        env.divider.claim(count, [&](uint64_t first, uint64_t last) {
+            if (!journal)
+            {
+                counter += process(first, last);
+                return;
+            }
 
-            if (Symm m = getRowsSymm(env, eastRows))
+            for (uint64_t end; first != last; first = end)
             {
-                env.sync(); fill(env, eastRows);
-                env.sync(); env.freeze->freeze(env.thread);
-                env.sync(); counter += m.prim * count(env, westRows, m.sec);
-                env.sync(); if (env.thread->accepted()) env.freeze->clear();
+                const uint64_t item = env.divider.item(first);
+                end = std::min(last, first + journal->unitEnd(item) - item);
+                const uint64_t subtotal = process(first, end);
+                journal->add({item, env.divider.item(end)},
+                             subtotal * symmetryFactor(env),
+                             env.thread->teamSize());
+                counter += subtotal;
             }
+        });
+
+        return counter;
+    }
+
+    static uint64_t symmetryFactor(auto& env)
+    {
+        if constexpr (requires { env.start.symmetryFactor(); })
+            return env.start.symmetryFactor();
+        else
+            return 1;
+    }
+
+    /* Work item with a plan (see WorkPlan): either only estimate its cost
+     * (for a sample of items), or process it and record elapsed time.
+     * Every item is added to the plan by a single thread.
+     */
+    uint64_t planItem(auto& env,
+                      WorkPlan& plan,
+                      uint64_t rank,
+                      const auto& cost,
+                      const auto& process) const
+    {
+        const uint64_t item = env.divider.item(rank);
+
+        if (plan.estimating())
+        {
+            if (plan.sampled(item) && env.thread->accepted())
+                plan.addEstimate(item, cost());
+
+            return 0;
+        }
+
+        const auto startClock = std::chrono::steady_clock::now();
+        const uint64_t res = process();
+        const std::chrono::duration<double> elapsed
+                = std::chrono::steady_clock::now() - startClock;
+
+        if (env.thread->accepted())
+            plan.addTime(item, elapsed.count());
+
+        return res;
+    }
+
+    /* Fill and count, usually in a single pass. If the sieve has a memory
+     * budget, patterns that do not fit are dropped by fill and both halves
+     * are processed again (for the remaining patterns only).
+     */
+    template<bool west>
+    uint64_t doPasses(auto& env,
+                      uint32_t fillRows,
+                      uint32_t countRows,
+                      unsigned symm) const
+    {
+        uint64_t counter = 0;
+
+        for (uint32_t lo = 0; lo != env.sink.matcherCount(); )
+        {
+            env.sync(); env.sink.startPass(lo); fill<west>(env, fillRows);
+            env.sync(); env.freeze->freeze(env.thread);
+            env.sync(); counter += count<!west>(env, countRows, symm);
+            lo = env.counter().passEnd();
+            env.sync(); if (env.thread->accepted()) env.freeze->clear();
         }
 
         return counter;
     }
 
-    /* Try to avoid double work if we already counted solutions for the board
-     * flipped upside down (north <-> south). And check if we could flip it
-     * left to right (east <-> west) just in case. Use left to right symmetry
-     * immediately for "queen in the center" case.
+    /* Usually east half-board is stored as patterns and west one is matched
+     * against them. Matching is symmetric, so for starts without diagonal
+     * symmetry (where every half-solution counts once) the half having less
+     * partial solutions may be stored instead: this needs less memory
+     * for patterns. Both halves are estimated by sizes of quarter_'s lists.
+     */
+    bool fillWest(auto& env, uint32_t eastRows, uint32_t westRows) const
+    {
+        if constexpr (env.start.diagSymmetry())
+        {
+            return false;
+        }
+        else
+        {
+            /* Each half is estimated by a single thread of the team. As in
+             * doHalf, this needs every thread to call accepted() the same
+             * number of times: each call is accepted by exactly one thread,
+             * whatever the order of tickets is. Barriers separate writing
+             * of the estimates, reading them and the next combination.
+             */
+            if (env.thread->accepted())
+                env.freeze->shared(0) = estimate<false>(env, eastRows);
+            if (env.thread->accepted())
+                env.freeze->shared(1) = estimate<true>(env, westRows);
+
+            env.sync();
+            const bool res = env.freeze->shared(1) < env.freeze->shared(0);
+            env.sync();
+            return res;
+        }
+    }
+
+    // Number of pairs of partial solutions for east/west half-board
+    template<bool west>
+    uint64_t estimate(auto& env, const uint32_t rows) const
+    {
+        const uint32_t halfColumns = halfBits<west>(env.start.getColumns());
+        const auto north = quarter_->withRows(loBits(rows));
+        const auto south = quarter_->withRows(hiBits(rows));
+        uint64_t total = 0;
+
+        quarter_->forCells(north, [&, this](const auto& northCell) {
+            if (northCell.columns & halfColumns)
+                return;
+
+            const auto sColumns = (northCell.columns ^ ~halfColumns) & lowHalf;
+            total += quarter_->listSize(north.makeCellInd(northCell))
+                   * quarter_->listSize(south.makeCellInd(sColumns));
+        });
+
+        return total;
+    }
+
+    /* Weights of row combination for north-south and east-west mirror
+     * images. Starts having such symmetry produce only unique combinations
+     * (see BitCombSymm), "queen in the center" case has both weights joined
+     * there. Other starts produce plain sets of rows.
      */
-    static Symm getRowsSymm(auto& env, uint32_t eastRows)
+    static Symm getRowsSymm(const SymmRows& comb)
     {
-        if (!env.start.internalSymmetry())
-            return {1, 1};
+        return {comb.northSouth, comb.eastWest};
+    }
 
-        const uint32_t revRows = revBits<size, halfSize>(eastRows);
-        const uint32_t eqRows = ~(eastRows ^ revRows) & env.start.getFreeRows();
-        const uint32_t eqBit = eqRows & -eqRows;
+    static Symm getRowsSymm(uint32_t)
+    {
+        return {1, 1};
+    }
 
-        const unsigned eastWest = eqRows
-                ? ((eastRows & eqBit)
-                   ? 2
-                   : 0)
-                : 1;
+    // Row combinations with ranks in [first, last)
+    static auto slice(const auto& combs, uint64_t first, uint64_t last)
+    {
+        if constexpr (requires { combs.slice(first, last); })
+            return combs.slice(first, last);
+        else // plain container
+            return std::span(combs).subspan(first, last - first);
+    }
 
-        const unsigned northSouth = (eastRows != revRows)
-                ? ((eastRows < revRows)
-                   ? 2
-                   : 0)
-                : 1;
+    static uint32_t combRows(const SymmRows& comb)
+    {
+        return comb.rows;
+    }
 
-        if (env.start.diagSymmetry())
-            return {northSouth, eastWest};
-        else // queen in the center
-            return {northSouth * eastWest, 1};
+    static uint32_t combRows(uint32_t bits)
+    {
+        return bits;
     }
 
-    // Process east half-board and store results
-    void fill(auto& env, uint32_t eastRows) const
+    // Process east (or west) half-board and store results
+    template<bool west>
+    void fill(auto& env, uint32_t rows) const
     {
-        doHalf<false>(env, eastRows, [&, this](const auto& d) {
+        doHalf<west>(env, rows, [&, this](const auto& d, CellColumns) {
             if (!env.start.diagSymmetry() || bothDiagsEmpty(d))
-                env.sink.appendPattern(joinQuarters<halfCeil, 0>(d));
+                env.sink.appendPattern(joinHalf<west>(d));
         });
     }
 
-    // Process west half-board and count matchings with east side
-    uint64_t count(auto& env, uint32_t westRows, unsigned symm) const
+    // Process west (or east) half-board and count matchings with other side
+    template<bool west>
+    uint64_t count(auto& env, uint32_t rows, unsigned symm) const
     {
         uint64_t total = 0;
-        doHalf<true>(env, westRows, [&, this](const auto& d) {
-            if (unsigned m = diagsSymmetryFactor(env, d, symm))
-                total += m * env.counter().count(joinQuarters<0, halfCeil>(d));
+        doHalf<west>(env, rows, [&, this](const auto& d, CellColumns cc) {
+            if (unsigned m = diagsSymmetryFactor(env, d, symm, rows, cc))
+                total += m * env.counter().count(joinHalf<west>(d));
         });
         return total;
     }
 
     /* For east/west half-board: for each column, set queen to north/south side
      * of the board, then request pairs of precomputed sets of occupied
-     * diagonals, and filter out incompatible pairs.
+     * diagonals, and filter out incompatible pairs. Action gets columns
+     * of both cells along with each pair.
      */
     template<bool west>
     void doHalf(auto& env, const uint32_t rows, const auto& action) const
     {
         const uint32_t halfColumns = halfBits<west>(env.start.getColumns());
-        const auto north = quarter_.withRows(loBits(rows));
-        const auto south = quarter_.withRows(hiBits(rows));
+        const auto north = quarter_->withRows(loBits(rows));
+        const auto south = quarter_->withRows(hiBits(rows));
 
-        quarter_.forCells(north, [&, this](const auto& northCell) {
+        quarter_->forCells(north, [&, this](const auto& northCell) {
             if ((northCell.columns & halfColumns) || env.thread->rejected())
                 return;
 
             const auto sColumns = (northCell.columns ^ ~halfColumns) & lowHalf;
             const auto northInd = north.makeCellInd(northCell);
             const auto southInd = south.makeCellInd(sColumns);
+            const CellColumns cc {northCell.columns, sColumns};
 
             forDiags<west>(env, northInd, southInd, [&](const auto& d) {
                 if (matchDiags<west>(env, d) && matchQuarters(d))
-                    action(d);
+                    action(d, cc);
             });
         });
     }
@@ -235,39 +449,77 @@ private:
         static constexpr bool filter =
               (env.start.diagSymmetry() && !west) || env.start.filterDiag();
 
-        quarter_.template forDiags<filter, west>(northInd, southInd, action);
+        if constexpr (hasMasks<decltype(env.start)>)
+        {
+            const auto masks = env.start.template quarterMasks<offset<west>>();
+            quarter_->template forDiags<filter, west>(
+                        northInd, southInd, masks, action);
+        }
+        else
+        {
+            quarter_->template forDiags<filter, west>(
+                        northInd, southInd, action);
+        }
     }
 
+    /* Checks diagonals against queens placed by env.start. Starts providing
+     * quarterMasks (constraints for each quarter separately) have this
+     * done while iterating quarter_'s lists, so that incompatible entries
+     * are skipped before making pairs.
+     */
     template<bool west>
     static bool matchDiags(auto& env, const auto& diags)
     {
-        return env.start.template matchDiags<west? halfCeil: 0>(diags);
+        if constexpr (hasMasks<decltype(env.start)>)
+            return true;
+        else
+            return env.start.template matchDiags<offset<west>>(diags);
     }
 
     /* Uses longest diagonals occupation to determine how many relatively
      * symmetrical solutions we have got. If both diagonals are empty try
      * to use east-west reflection.
+     *
+     * If only one of them is occupied, its queen lies in a west quarter
+     * that is mapped onto itself by reflection in this diagonal. The other
+     * longest diagonal is empty and does not tell this reflection apart.
+     * But rows and columns of this quarter are swapped by it, so only
+     * the reflected solution with smaller sets of rows is counted (twice).
+     * North quarter gets the same treatment after flipping it north to
+     * south (to keep factor the same for every pair of mirrored row
+     * combinations).
      */
     static unsigned diagsSymmetryFactor(
                 auto& env,
                 const auto& diags,
-                unsigned symm)
+                unsigned symm,
+                uint32_t rows,
+                CellColumns cc)
     {
-        unsigned symmetryFactor = 1;
-
-        if (env.start.diagSymmetry())
-        {
-            if (!isLongestHalfDiagEmpty(diags.first[1]))
-                symmetryFactor *= 2;
-
-            if (!isLongestHalfDiagEmpty(diags.second[0]))
-                symmetryFactor *= 2;
-
-            if (symmetryFactor == 1)
-                symmetryFactor = symm;
-        }
+        if (!env.start.diagSymmetry())
+            return 1;
+
+        const bool north = !isLongestHalfDiagEmpty(diags.first[1]);
+        const bool south = !isLongestHalfDiagEmpty(diags.second[0]);
+
+        if (north && south)
+            return 4;
+        else if (south)
+            return 2 * reflectionFactor(hiBits(rows), cc.south);
+        else if (north)
+            return 2 * reflectionFactor(
+                        revBits<halfSize, halfSize>(loBits(rows)), cc.north);
+        else
+            return symm;
+    }
 
-        return symmetryFactor;
+    static unsigned reflectionFactor(uint32_t rows, uint32_t columns)
+    {
+        return (rows != columns)
+                ? ((rows < columns)
+                   ? 2
+                   : 0)
+                : 1;
     }
 
     /* Returns false to filter out redundant half-solutions based on
@@ -303,6 +555,16 @@ private:
         );
     }
 
+    // Diagonals of half-board shifted to common position
+    template<bool west>
+    static auto joinHalf(const auto& diags)
+    {
+        if constexpr (west)
+            return joinQuarters<0, halfCeil>(diags);
+        else
+            return joinQuarters<halfCeil, 0>(diags);
+    }
+
     template<bool west>
     static uint32_t halfBits(uint32_t bits)
     {
@@ -321,9 +583,25 @@ private:
 
     static constexpr int halfSize = size / 2;
     static constexpr int halfCeil = (size + 1) / 2;
+
+    /* joinQuarters shifts 32-bit diagonals by halfCeil, so for size > 23
+     * their highest bits are lost. Sieves use only the low size - 1 bits
+     * of each joined diagonal (see Sieve::stitch), and these are kept.
+     */
+    static_assert(size < 32);
     static constexpr uint32_t lowHalf = nLeastBits<uint32_t>(halfSize);
 
-    Quarter quarter_;
+    template<class Start>
+    static constexpr bool hasMasks = requires (const Start& start) {
+        start.template quarterMasks<0>();
+    };
+
+    template<bool west>
+    static constexpr int offset = west? halfCeil: 0;
+
+    using Diagonals = std::array<uint32_t, 2>;
+
+    std::shared_ptr<Quarter> quarter_;
 };
 
 #endif // QUADRANTS1_H
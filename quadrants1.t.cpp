@@ -24,7 +24,7 @@ using DP = std::pair<uint32_t, uint32_t>;
 
 struct MockStart
 {
-    using BitComb = std::array<uint32_t, 1>;
+    using BitComb = std::array<SymmRows, 1>;
     MOCK_METHOD(BitComb, getBitComb, (), (const));
     MOCK_METHOD(uint32_t, stretchRows, (uint32_t bits), (const));
     MOCK_METHOD(uint32_t, getFreeRows, (), (const));
@@ -41,11 +41,6 @@ struct MockStart
             return matchDiagsE(d);
     }
 
-    static constexpr bool internalSymmetry()
-    {
-        return true;
-    }
-
     static constexpr bool diagSymmetry()
     {
         return true;
@@ -62,6 +57,19 @@ struct MockSieve
     MOCK_METHOD(void, appendPattern, (const DP& d));
     MOCK_METHOD(uint64_t, count, (const DP d), (const));
     MOCK_METHOD(void, clear, ());
+
+    void startPass(uint32_t)
+    {}
+
+    uint32_t passEnd() const
+    {
+        return 1;
+    }
+
+    static constexpr uint32_t matcherCount()
+    {
+        return 1;
+    }
 };
 
 struct FakeCell
@@ -91,7 +99,7 @@ struct FakeQuarter
 
     void forCells(const MockCellFactory&, const auto& action) const
     {
-        action(FakeCell{0});
+        action(FakeCell{northColumns});
     }
 
     template<bool filterDiags, bool other>
@@ -117,6 +125,8 @@ struct FakeQuarter
     {
         return false;
     }
+
+    static inline uint32_t northColumns = 0;
 };
 
 struct FakeThread
@@ -124,6 +134,11 @@ struct FakeThread
     void sync() const
     {}
 
+    std::ptrdiff_t teamSize() const
+    {
+        return 1;
+    }
+
     [[nodiscard]] bool accepted()
     {
         return !rejected();
@@ -179,11 +194,14 @@ protected:
     void SetUp() override
     {
         f.ptr = &env.sink;
+        FakeQuarter::northColumns = 0;
 
         ON_CALL(env.start, getFreeRows)
                 .WillByDefault(t::Return(0xFF));
+        ON_CALL(env.start, stretchRows)
+                .WillByDefault(t::ReturnArg<0>());
         EXPECT_CALL(env.start, getBitComb())
-                .WillOnce(t::Return(bitComb));
+                .WillOnce(t::ReturnPointee(&bitComb));
         EXPECT_CALL(env.start, matchDiagsE)
                 .WillOnce(t::Return(false))
                 .WillRepeatedly(t::Return(true));
@@ -198,7 +216,7 @@ protected:
         t::DefaultValue<FakeCellInd>::Set({&eastD, &westD});
     }
 
-    std::array<uint32_t, 1> bitComb{};
+    MockStart::BitComb bitComb {{{0, 1, 0}}};
     FakeThread t;
     FakeFreeze f;
     FakeContext env {t::NiceMock<MockStart>{}, &t,
@@ -238,16 +256,38 @@ TEST_F(Quadrants1Test, DiagsSymmetry2B)
     EXPECT_CALL(env.sink, appendPattern)
             .Times(1);
 
+    FakeQuarter::northColumns = 0x0F; // same as rows
     westD = {{0, 8}, {0, 0}};
     EXPECT_EQ(quadrants(env), 2u);
 }
 
+TEST_F(Quadrants1Test, ReflectionSymmetry2South)
+{
+    EXPECT_CALL(env.sink, appendPattern)
+            .Times(1);
+    bitComb[0] = {0x81, 1, 2};
+
+    FakeQuarter::northColumns = 0x01; // south: rows 0x07 < columns 0x0E
+    westD = {{0, 0}, {8, 0}};
+    EXPECT_EQ(quadrants(env), 4u);
+}
+
+TEST_F(Quadrants1Test, ReflectionSymmetry2North)
+{
+    EXPECT_CALL(env.sink, appendPattern)
+            .Times(1);
+    bitComb[0] = {0x81, 1, 2};
+
+    FakeQuarter::northColumns = 0x09; // north: rows 0x0E, reversed 0x07
+    westD = {{0, 8}, {0, 0}};
+    EXPECT_EQ(quadrants(env), 4u);
+}
+
 TEST_F(Quadrants1Test, DiagsSymmetry1ButEastWest2)
 {
     EXPECT_CALL(env.sink, appendPattern)
             .Times(1);
-    ON_CALL(env.start, stretchRows)
-            .WillByDefault(t::Return(0xFF));
+    bitComb[0] = {0xFF, 1, 2};
 
     westD = {{0, 0}, {0, 0}};
     EXPECT_EQ(quadrants(env), 2u);
@@ -257,8 +297,7 @@ TEST_F(Quadrants1Test, DiagsSymmetry1ButNorthSouth2)
 {
     EXPECT_CALL(env.sink, appendPattern)
             .Times(1);
-    ON_CALL(env.start, stretchRows)
-            .WillByDefault(t::Return(0x0F));
+    bitComb[0] = {0x0F, 2, 1};
 
     westD = {{0, 0}, {0, 0}};
     EXPECT_EQ(quadrants(env), 2u);
@@ -1,6 +1,7 @@
 #ifndef SCHEDULERMT_H
 #define SCHEDULERMT_H
 
+#include <algorithm>
 #include <atomic>
 #include <barrier>
 #include <cstddef>
@@ -31,6 +32,11 @@ public:
 
     uint64_t launch(const auto& fn);
 
+    std::ptrdiff_t workerCount() const
+    {
+        return workerCount_;
+    }
+
 private:
     friend class ThreadMT;
     std::ptrdiff_t workerCount_;
@@ -46,6 +52,11 @@ public:
         scheduler_->barrier_.arrive_and_wait();
     }
 
+    std::ptrdiff_t teamSize() const
+    {
+        return scheduler_->workerCount_;
+    }
+
     [[nodiscard]] bool accepted()
     {
         return !rejected();
@@ -78,6 +89,7 @@ uint64_t SchedulerMT::launch(const auto& fn)
 {
     std::vector<std::future<uint64_t>> fut(workerCount_);
     uint64_t total = 0;
+    work_ = 2; // every launch numbers its work from start
 
     auto launcher = [&] {
         ThreadMT thread{this};
@@ -94,6 +106,31 @@ uint64_t SchedulerMT::launch(const auto& fn)
     return total;
 }
 
+/* Calls fn(i) for each i in [0, count) using up to "workers" threads.
+ * Tasks are handed out dynamically, so they may differ in size. Intended for
+ * work done outside of launch() (like building lookup tables).
+ */
+void parallelFor(std::ptrdiff_t workers, uint32_t count, const auto& fn)
+{
+    std::atomic_uint32_t next = 0;
+
+    auto worker = [&] {
+        for (uint32_t i; (i = next.fetch_add(1)) < count; )
+            fn(i);
+    };
+
+    const std::ptrdiff_t helpers = std::min<std::ptrdiff_t>(workers, count) - 1;
+    std::vector<std::future<void>> fut(std::max<std::ptrdiff_t>(helpers, 0));
+
+    for (auto& slot: fut)
+        slot = std::async(std::launch::async, worker);
+
+    worker();
+
+    for (auto& slot: fut)
+        slot.get();
+}
+
 using Scheduler = SchedulerMT;
 using ThreadPolicy = ThreadPolicyMT;
 
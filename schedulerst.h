@@ -24,6 +24,11 @@ struct SchedulerST
     {}
 
     uint64_t launch(const auto& fn);
+
+    std::ptrdiff_t workerCount() const
+    {
+        return 1;
+    }
 };
 
 class ThreadST
@@ -32,6 +37,11 @@ public:
     void sync() const
     {}
 
+    std::ptrdiff_t teamSize() const
+    {
+        return 1;
+    }
+
     [[nodiscard]] bool accepted()
     {
         return !rejected();
@@ -52,6 +62,12 @@ uint64_t SchedulerST::launch(const auto& fn)
     return fn(thread);
 }
 
+void parallelFor(std::ptrdiff_t, uint32_t count, const auto& fn)
+{
+    for (uint32_t i = 0; i != count; ++i)
+        fn(i);
+}
+
 using Scheduler = SchedulerST;
 using ThreadPolicy = ThreadPolicyST;
 
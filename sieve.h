@@ -1,8 +1,11 @@
 #ifndef SIEVE_H
 #define SIEVE_H
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <ranges>
 
 #include "bmintrin.h"
@@ -18,6 +21,13 @@
  * is arranged to visit only matchers that correspond to its bit pattern
  * (that's why this is named Sieve).
  *
+ * Memory used by matchers may be limited with setBudget(). Then patterns
+ * are processed in several passes, each pass keeping only matchers
+ * [lo_, hi_): when the budget is exceeded, matchers at the end of this range
+ * are dropped (they are handled by next passes). Caller should repeat
+ * the whole stream of patterns (and items) for every pass, starting with
+ * startPass(passEnd() of previous pass), until all matchers are done.
+ *
  * Template parameters:
  * Match - class that performs bitset matching
  * cfg - configuration parameters
@@ -36,10 +46,47 @@ public:
         holes_ = ~(hcat | cuts_);
     }
 
+    // Limit memory used by patterns (zero: no limit)
+    void setBudget(std::size_t bytes)
+    {
+        maxPatterns_ = bytes
+                ? std::max<uint64_t>(bytes / Match<ml, cfg>::bytesPerPattern(),
+                                     1)
+                : std::numeric_limits<uint64_t>::max();
+    }
+
+    // Begin next pass, which uses matchers starting from "lo"
+    void startPass(uint32_t lo)
+    {
+        lo_ = lo;
+        hi_ = cutSize_;
+        stored_ = 0;
+    }
+
+    // Where current pass ends (valid after stream of patterns ends)
+    uint32_t passEnd() const
+    {
+        return hi_;
+    }
+
+    // Number of matchers (all passes together use each of them once)
+    static constexpr uint32_t matcherCount()
+    {
+        return cutSize_;
+    }
+
     void appendPattern(const auto& diags)
     {
         const auto sb = stitch(diags);
-        match_[cutMask_ & ~sb.index].appendPattern(sb.bits);
+        const uint32_t i = cutMask_ & ~sb.index;
+
+        if (i < lo_ || i >= hi_)
+            return; // not in this pass
+
+        match_[i].appendPattern(sb.bits);
+
+        if (++stored_ > maxPatterns_)
+            dropMatchers();
     }
 
     // Should be called when stream of patterns ends.
@@ -55,23 +102,37 @@ public:
         const auto sb = stitch(diags);
         auto next = [&sb](auto i) { return (i + 1) | sb.index; };
 
-        for (uint64_t i = sb.index; i != cutMask_; i = next(i))
+        uint64_t i = sb.index;
+
+        while (i < lo_)
+            i = next(i);
+
+        for (; i != cutMask_ && i < hi_; i = next(i))
         {
             match_[next(i)].prefetch(sb.bits);
             total += match_[i].count(sb.bits);
         }
 
-        total += match_[cutMask_].count(sb.bits);
+        if (i < hi_)
+            total += match_[cutMask_].count(sb.bits);
+
         return total;
     }
 
     /* Pull patterns from matchers pointed by ptrs and pass them to local
      * matchers. This is the only thread-aware method of this class. It
      * divides work between threads so that each thread gets a disjoint subset
-     * of matchers array.
+     * of matchers array. Current pass ends where it ends for any of ptrs;
+     * patterns beyond that are dropped.
      */
     void pull(const std::ranges::range auto ptrs, auto* thread)
     {
+        const uint32_t lo = ptrs[0]->lo_;
+        uint32_t hi = cutSize_;
+
+        for (auto* p: ptrs)
+            hi = std::min(hi, p->hi_);
+
         for (uint32_t i = 0; i != cutSize_; ++i)
         {
             if (thread->rejected())
@@ -81,10 +142,17 @@ public:
             {
                 holes_ = ptrs[0]->holes_;
                 cuts_ = ptrs[0]->cuts_;
+                lo_ = lo;
+                hi_ = hi;
             }
 
             for (auto* p: ptrs)
-                p->match_[i].passTo(match_[i]);
+            {
+                if (i >= lo && i < hi)
+                    p->match_[i].passTo(match_[i]);
+                else
+                    p->match_[i].clear();
+            }
 
             match_[i].closePatterns();
         }
@@ -109,6 +177,17 @@ private:
         uint64_t index;
     };
 
+    // Free matchers at the end of current pass until budget is met
+    void dropMatchers()
+    {
+        while (stored_ > maxPatterns_ && hi_ > lo_ + 1)
+        {
+            --hi_;
+            stored_ -= match_[hi_].patternCount();
+            match_[hi_].clear();
+        }
+    }
+
     SrcBits stitch(const auto& diags) const
     {
         return splitBits(((uint64_t{diags.second} & halfMask_) << halfLen)
@@ -170,6 +249,10 @@ private:
     std::array<Match<ml, cfg>, cutSize_> match_;
     uint64_t cuts_ = mkCuts(~centerBits_);
     uint64_t holes_ = ~(centerBits_ | cuts_);
+    uint64_t maxPatterns_ = std::numeric_limits<uint64_t>::max();
+    uint64_t stored_ = 0; // patterns appended in current pass
+    uint32_t lo_ = 0;
+    uint32_t hi_ = cutSize_;
 };
 
 #endif // SIEVE_H
@@ -1,11 +1,15 @@
 #include "sieve.h"
 
 #include <bit>
+#include <cstdint>
+#include <random>
 #include <utility>
+#include <vector>
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
 #include "bmintrin.h"
+#include "matchtr.h"
 
 namespace t = testing;
 
@@ -19,6 +23,8 @@ struct FakeMatch
     void shrink() {}
     void passTo(FakeMatch<size, cfg>&) {}
     void prefetch(uint64_t) const {}
+    size_t patternCount() const { return 0; }
+    static constexpr size_t bytesPerPattern() { return 8; }
 };
 
 template<bool bmi, int cut>
@@ -54,3 +60,58 @@ TEST(SieveTest, Count)
     if constexpr (isBMAvail)
         testSieveCount<true>();
 }
+
+TEST(SieveTest, Passes)
+{
+    using Sv = Sieve<MatchTr, Cfg{.sieveCuts = 2}, 17, 0>;
+    using DP = std::pair<uint32_t, uint32_t>;
+    std::mt19937 gen(1);
+
+    auto sparse = [&gen] {
+        return static_cast<uint32_t>(gen() & gen() & gen()) & 0x1FFFF;
+    };
+
+    std::vector<DP> patterns(5000);
+    std::vector<DP> items(300);
+
+    for (auto& p: patterns)
+        p = {sparse(), sparse()};
+
+    for (auto& i: items)
+        i = {sparse(), sparse()};
+
+    auto countPass = [&](Sv& sieve) {
+        uint64_t total = 0;
+
+        for (const auto& p: patterns)
+            sieve.appendPattern(p);
+
+        sieve.closePatterns();
+
+        for (const auto& i: items)
+            total += sieve.count(i);
+
+        sieve.clear();
+        return total;
+    };
+
+    Sv whole;
+    const uint64_t expected = countPass(whole);
+    EXPECT_EQ(whole.passEnd(), Sv::matcherCount());
+
+    Sv limited;
+    limited.setBudget(2000 * MatchTr<34, Cfg{}>::bytesPerPattern());
+    uint64_t total = 0;
+    int passes = 0;
+
+    for (uint32_t lo = 0; lo != Sv::matcherCount(); ++passes)
+    {
+        limited.startPass(lo);
+        total += countPass(limited);
+        ASSERT_GT(limited.passEnd(), lo);
+        lo = limited.passEnd();
+    }
+
+    EXPECT_EQ(total, expected);
+    EXPECT_GT(passes, 1);
+}
@@ -1,15 +1,27 @@
 #ifndef SOLCOUNTER_H
 #define SOLCOUNTER_H
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "bitcombcolex.h"
+#include "bmintrin.h"
 #include "cfg.h"
 #include "divider.h"
 #include "freeze.h"
+#include "lazysubsquare.h"
 #include "matchtr.h"
 #include "pack.h"
+#include "prefetch.h"
+#include "qdiags.h"
+#include "qgenerator.h"
 #include "qsymmetry.h"
 #include "quadrants1.h"
 #include "scheduler.h"
@@ -18,24 +30,199 @@
 #include "startempty.h"
 #include "subsquare.h"
 
-inline constexpr int size = 18;
-inline constexpr Cfg cfg { // s= 16   17   18   19   20   21   22
-    .sieveCuts = 0,        //     0    0    0    0    3    3    6
-    .matchMinSize = 40,    //    40   40   40   40   60   60   80
-    .bmiIntrin = false,    //     F    F    F    T    T    T    T
-    .prefetch = false,     //     T    T    T    T    *    F    T
-    // Subsquare Symmetry      NoSy NoSy NoSy NoSy NoSy NoSy RowS
+inline constexpr int size = 18; // unless sizes are given in command line
+
+/* Board sizes that could be requested in command line (batch mode). Sizes
+ * up to 20 were checked against known counts; larger ones may be counted
+ * one at a time (see size).
+ */
+inline constexpr int minBatchSize = 8;
+inline constexpr int maxBatchSize = 20;
+
+// Size of quarter-board table needed for board size n
+constexpr int quarterSize(int n)
+{
+    return n / 2;
+}
+
+// Performance tuning for board size n (values for n = 16..22 are listed)
+consteval Cfg cfgFor(const int n)
+{
+    return Cfg {                                 // s= 16 17 18 19 20 21 22
+        .sieveCuts = (n < 20) ? 0 : (n < 22) ? 3 : 6,   // 0  0  0  0  3  3  6
+        .matchMinSize = (n < 20) ? 40 : (n < 22) ? 60 : 80,
+                                                 //    40 40 40 40 60 60 80
+        .bmiIntrin = isBMAvail && n >= 19,       //     F  F  F  T  T  T  T
+        .prefetch = isPFAvail && n != 21,        //     T  T  T  T  *  F  T
+    };
+}
+
+/* Memory limit (in bytes) for quarter-board lists. Zero: whole table is
+ * generated in advance (fastest) if it fits into memory limit (and tables
+ * in memory mapped files fit into free disk space); otherwise lists are
+ * generated on demand and cached (see LazySubsquare) within memory left
+ * by planMemory. Non-zero value forces lists on demand for all sizes.
+ */
+inline constexpr std::size_t quarterBudget = 0;
+
+// Smallest quarter-board that may be replaced by lists on demand
+inline constexpr int lazyMinK = 10; // smaller tables take less than 10 MB
+
+/* Subsquare for board size 2k or 2k+1. Symmetry: NoSy for n <= 21, RowS
+ * for 22 and larger. Storage: plain for n <= 19 (table fits in cache),
+ * packed for larger sizes (less memory and bandwidth), memory mapped files
+ * for n >= 24 (table for n = 26..27 is estimated at about 25 GB).
+ */
+template<int k>
+using QuarterFor = std::conditional_t<(k < 10),
+                        Subsquare<k, QNoSymmetry, PackIter>,
+                    std::conditional_t<(k < 11),
+                        Subsquare<k, QNoSymmetry, PackIter,
+                                  QBacktrack, DiagsPacked>,
+                    std::conditional_t<(k < 12),
+                        Subsquare<k, QRowSymmetry, PackIter,
+                                  QBacktrack, DiagsPacked>,
+                        Subsquare<k, QRowSymmetry, PackIter,
+                                  QBacktrack, DiagsMapped>>>>;
+
+// Quarter-board lists generated on demand (if QuarterFor<k> does not fit)
+template<int k>
+using LazyQuarterFor = LazySubsquare<k, DiagsPacked>;
+
+// Whether lists of quarter-board table for given k may be generated on demand
+constexpr bool lazyAllowed(int k)
+{
+    return quarterBudget != 0 || k >= lazyMinK;
+}
+
+// Number of partial solutions (0..k queens) on k x k quarter-board, k <= 13
+inline constexpr std::array<uint64_t, 14> quarterPieces {
+    1, 2, 5, 18, 87, 462, 2635, 16870, 118969, 915442, 7535369, 66807234,
+    633443407, 6354135838};
+
+// Memory not included in estimates (code, stacks, small tables)
+inline constexpr std::size_t reservedBytes = std::size_t{64} << 20;
+
+// Least amount of memory for half-board patterns per thread
+inline constexpr std::size_t threadBytes = std::size_t{16} << 20;
+
+// Least amount of memory for quarter-board lists generated on demand
+inline constexpr std::size_t lazyBytes = std::size_t{16} << 20;
+
+/* How the work fits into memory limit. sieveBudget is the limit for
+ * half-board patterns stored by sieves (for all threads together):
+ * patterns that do not fit are dropped and both half-boards are processed
+ * again for them (see Sieve), several times if needed. This works only
+ * for sizes with non-zero sieveCuts (smaller sizes need little memory).
+ * Non-zero listsBudget means that quarter-board tables do not fit:
+ * their lists are generated on demand (for k >= lazyMinK) and this is
+ * the limit for cached lists.
+ */
+struct MemPlan
+{
+    int threads; // zero if even minimal configuration does not fit
+    std::size_t sieveBudget;
+    std::size_t listsBudget;
+    std::size_t required; // minimal amount of memory
+};
+
+// Estimated memory and size of mapped files for quarter-board table
+struct QuarterCost
+{
+    std::size_t memory;
+    std::size_t files;
 };
 
-using Quarter = Subsquare<size / 2, QNoSymmetry, PackIter>;
-using Quadrants = Quadrants1<size, Quarter>;
+QuarterCost quarterCost(int k)
+{
+    static constexpr int minK = minBatchSize / 2;
+    static constexpr int maxK = std::max(maxBatchSize, size) / 2;
+    static_assert(maxK < quarterPieces.size());
+    QuarterCost res {};
+
+    [&]<int... ks>(std::integer_sequence<int, ks...>) {
+        ((k == ks + minK
+          ? void(res = {
+                QuarterFor<ks + minK>::estimateBytes(quarterPieces[ks + minK]),
+                QuarterFor<ks + minK>::estimateFileBytes(
+                    quarterPieces[ks + minK])})
+          : void()), ...);
+    }(std::make_integer_sequence<int, maxK - minK + 1>{});
+
+    return res;
+}
+
+/* Choose the number of threads (not more than requested) and memory limit
+ * for patterns. In batch mode the table for previous board sizes may be
+ * kept while the next one is built. If tables do not fit, memory is split
+ * evenly between lists generated on demand and patterns (at least
+ * threadBytes for patterns). Tables that may not be replaced by lists
+ * (see lazyAllowed) are still kept whole, as withQuarter does.
+ */
+MemPlan planMemory(const std::vector<int>& sizes,
+                   int threads,
+                   std::size_t limit)
+{
+    QuarterCost quarter {};
+    std::size_t kept = 0; // tables that are never replaced by lists
+    bool lazy = false;
+
+    for (int n: sizes)
+    {
+        const int k = quarterSize(n);
+        const QuarterCost prev = (sizes.size() > 1 && k > minBatchSize / 2)
+                ? quarterCost(k - 1)
+                : QuarterCost{};
+        const QuarterCost curr = quarterCost(k);
+        quarter.memory = std::max(quarter.memory, curr.memory + prev.memory);
+        quarter.files = std::max(quarter.files, curr.files + prev.files);
+
+        if (lazyAllowed(k))
+            lazy = true;
+        else
+            kept = std::max(kept, curr.memory + prev.memory);
+    }
+
+    auto plan = [&](std::size_t quarterMemory, std::size_t listsBudget) {
+        const std::size_t required = reservedBytes + quarterMemory
+                                     + threadBytes;
+
+        if (limit < required)
+            return MemPlan{0, 0, 0, required};
+
+        const std::size_t rest = limit - reservedBytes - quarterMemory;
+        const auto fit = std::min<std::size_t>(
+                    rest / threadBytes, static_cast<std::size_t>(threads));
+        return MemPlan{static_cast<int>(fit), rest, listsBudget, required};
+    };
+
+    if (quarterBudget != 0)
+        return plan(quarterBudget, quarterBudget);
+
+    const MemPlan whole = plan(quarter.memory, 0);
+
+    if (!lazy || (whole.threads != 0 && (quarter.files == 0
+                                         || quarter.files <= mapDirSpace())))
+        return whole;
+
+    const std::size_t avail = limit - std::min(limit, reservedBytes + kept);
+    const std::size_t patterns = std::max(avail / 2, threadBytes);
+    const std::size_t lists = std::max(lazyBytes,
+                                       avail - std::min(avail, patterns));
+    return plan(kept + lists, lists);
+}
 
 template<class Start>
-uint64_t countStep(auto& thread, auto& frzs, auto& quad, Divider& div)
+uint64_t countStep(auto& thread,
+                   auto& frzs,
+                   auto& quad,
+                   Divider& div,
+                   std::size_t budget)
 {
     using Sieve = Start::Sieve_;
     auto& frz = std::get<Freeze<Sieve, Start>>(frzs);
     Context env{Start{}, &thread, Sieve{}, &frz, div};
+    env.sink.setBudget(budget);
     frz.reg(&env.sink);
     uint64_t res;
 
@@ -45,39 +232,225 @@ uint64_t countStep(auto& thread, auto& frzs, auto& quad, Divider& div)
         res = quad(env);
 
     quad.shrink(env);
+    div = env.divider; // next start continues numbering of work items
     return res;
 }
 
-template<class... Starts>
-uint64_t countSteps(Scheduler& sch, Divider& div)
+template<class Quadrants, class... Starts>
+uint64_t countSteps(Scheduler& sch,
+                    Divider& div,
+                    auto quarter,
+                    std::size_t sieveBudget)
 {
     std::tuple<Freeze<typename Starts::Sieve_, Starts>...> frzs;
-    Quadrants quad;
+    Quadrants quad(std::move(quarter));
+
+    // Patterns are held by every thread and then by frozen copy
+    const std::size_t budget = ThreadPolicy::isThreaded()
+            ? sieveBudget / (2 * static_cast<std::size_t>(sch.workerCount()))
+            : sieveBudget;
 
     return sch.launch([&](auto& thread) {
-        return (... + countStep<Starts>(thread, frzs, quad, div));
+        Divider threadDiv = div;
+        uint64_t res = 0;
+        ((res += countStep<Starts>(thread, frzs, quad, threadDiv, budget)),
+         ...);
+        return res;
     });
 }
 
-uint64_t countSolutions(int threads, int part, int parts)
+// Count solutions for board of size n using existing quarter-board table
+template<int n, class Quarter>
+uint64_t countSolutions(Scheduler& sch,
+                        Divider div,
+                        std::shared_ptr<Quarter> quarter,
+                        std::size_t sieveBudget)
 {
-    Scheduler sch(threads);
-    Divider div(part, parts);
+    static constexpr Cfg cfg = cfgFor(n);
+    using Quadrants = Quadrants1<n, Quarter>;
+    quarter->resetSBit(); // may be left by previous run
 
-    if (size & 1)
+    if constexpr (n & 1)
     {
-        return countSteps<
-                    StartCenter<size, MatchTr, BitCombColex, cfg>,
-                    Start2D<size, MatchTr, BitCombColex, cfg>,
-                    Start1D<size, MatchTr, BitCombColex, cfg>
-                >(sch, div);
+        return countSteps<Quadrants,
+                    StartCenter<n, MatchTr, BitCombColex, cfg>,
+                    Start2D<n, MatchTr, BitCombColex, cfg>,
+                    Start1D<n, MatchTr, BitCombColex, cfg>
+                >(sch, div, std::move(quarter), sieveBudget);
     }
     else
     {
-        return countSteps<
-                    StartEmpty<size, MatchTr, BitCombColex, cfg>
-                >(sch, div);
+        return countSteps<Quadrants,
+                    StartEmpty<n, MatchTr, BitCombColex, cfg>
+                >(sch, div, std::move(quarter), sieveBudget);
     }
 }
 
+// Number of work items (see Divider) for board of given size
+template<int n>
+constexpr uint64_t workItems()
+{
+    constexpr Cfg cfg = cfgFor(n);
+
+    if constexpr (n & 1)
+    {
+        return StartCenter<n, MatchTr, BitCombColex, cfg>::workItems()
+             + Start2D<n, MatchTr, BitCombColex, cfg>::workItems()
+             + Start1D<n, MatchTr, BitCombColex, cfg>::workItems();
+    }
+    else
+    {
+        return StartEmpty<n, MatchTr, BitCombColex, cfg>::workItems();
+    }
+}
+
+// Calls fn(sch, quarter) with quarter-board table for the board of "size"
+auto withQuarter(Scheduler& sch, std::size_t listsBudget, const auto& fn)
+{
+    static constexpr int k = quarterSize(size);
+
+    if constexpr (lazyAllowed(k))
+    {
+        if (listsBudget != 0)
+        {
+            return fn(std::make_shared<LazyQuarterFor<k>>(sch.workerCount(),
+                                                          listsBudget));
+        }
+    }
+
+    return fn(std::make_shared<QuarterFor<k>>(sch.workerCount()));
+}
+
+uint64_t countSolutions(int threads,
+                        Divider div,
+                        std::size_t sieveBudget,
+                        std::size_t listsBudget)
+{
+    Scheduler sch(threads);
+
+    return withQuarter(sch, listsBudget, [&](const auto& quarter) {
+        return countSolutions<size>(sch, div, quarter, sieveBudget);
+    });
+}
+
+/* Worker mode (see Coordinator): the quarter-board table is built once,
+ * then ranges of work items are counted while next(range) returns true.
+ * Calls reply(range, result) after each range.
+ */
+void countRanges(int threads,
+                 std::size_t sieveBudget,
+                 std::size_t listsBudget,
+                 const auto& next,
+                 const auto& reply)
+{
+    Scheduler sch(threads);
+
+    withQuarter(sch, listsBudget, [&](const auto& quarter) {
+        for (Divider::Range range; next(range); )
+        {
+            reply(range, countSolutions<size>(sch, Divider(0, 1, {range}),
+                                              quarter, sieveBudget));
+        }
+    });
+}
+
+/* Batch mode: count solutions for several board sizes (in ascending order).
+ * Sizes 2k and 2k+1 share the same quarter-board table. Where possible,
+ * the table is derived from the one for previous k (see QExtend). Calls
+ * report(size, result) after each size.
+ */
+template<int... ks>
+void countSolutions(int threads,
+                    Divider div,
+                    std::size_t sieveBudget,
+                    std::size_t listsBudget,
+                    const std::vector<int>& sizes,
+                    const auto& report,
+                    std::integer_sequence<int, ks...>)
+{
+    Scheduler sch(threads);
+    std::shared_ptr<void> prev; // quarter for previous k (if needed)
+
+    auto wanted = [&sizes](int n) {
+        return std::ranges::find(sizes, n) != sizes.end();
+    };
+
+    auto forQuarter = [&]<int k>(std::integral_constant<int, k>) {
+        static constexpr int even = 2 * k;
+        static constexpr int odd = 2 * k + 1;
+
+        if (!wanted(even) && !wanted(odd))
+        {
+            prev.reset();
+            return;
+        }
+
+        auto count = [&]<int n>(std::integral_constant<int, n>,
+                                const auto& quarter) {
+            if constexpr (n >= minBatchSize && n <= maxBatchSize)
+            {
+                if (wanted(n))
+                    report(n, countSolutions<n>(sch, div, quarter,
+                                                sieveBudget));
+            }
+        };
+
+        auto countBoth = [&](const auto& quarter) {
+            count(std::integral_constant<int, even>{}, quarter);
+            count(std::integral_constant<int, odd>{}, quarter);
+        };
+
+        if constexpr (lazyAllowed(k))
+        {
+            if (listsBudget != 0)
+            {
+                prev.reset(); // only QuarterFor<k> is used by QExtend
+                countBoth(std::make_shared<LazyQuarterFor<k>>(
+                              sch.workerCount(), listsBudget));
+                return;
+            }
+        }
+
+        using Quarter = QuarterFor<k>;
+        using Source = QuarterFor<k - 1>;
+        std::shared_ptr<Quarter> quarter;
+
+        if constexpr (requires (const Source& s) {
+                          s.forRowPieces(0, [](uint32_t, auto) {}); })
+        {
+            if (prev)
+            {
+                const auto& src = *static_cast<const Source*>(prev.get());
+                quarter = std::make_shared<Quarter>(sch.workerCount(),
+                                                    QExtend<k, Source>{src});
+            }
+        }
+
+        if (!quarter)
+            quarter = std::make_shared<Quarter>(sch.workerCount());
+
+        prev = quarter;
+        countBoth(quarter);
+    };
+
+    (forQuarter(std::integral_constant<int, ks>{}), ...);
+}
+
+void countSolutions(int threads,
+                    Divider div,
+                    std::size_t sieveBudget,
+                    std::size_t listsBudget,
+                    const std::vector<int>& sizes,
+                    const auto& report)
+{
+    static constexpr int minK = minBatchSize / 2;
+    static constexpr int maxK = maxBatchSize / 2;
+
+    [&]<int... ks>(std::integer_sequence<int, ks...>) {
+        countSolutions(threads, div, sieveBudget, listsBudget,
+                       sizes, report,
+                       std::integer_sequence<int, (ks + minK)...>{});
+    }(std::make_integer_sequence<int, maxK - minK + 1>{});
+}
+
 #endif // SOLCOUNTER_H
@@ -0,0 +1,38 @@
+#include "solcounter.h"
+
+#include <cstddef>
+#include <memory>
+#include <gtest/gtest.h>
+
+// Lists on demand are planned only for tables that withQuarter replaces
+TEST(SolCounterTest, PlanMemory)
+{
+    static_assert(!lazyAllowed(8) && lazyAllowed(10));
+
+    const std::size_t small = quarterCost(8).memory;
+    const MemPlan whole = planMemory({16}, 4, reservedBytes + threadBytes
+                                              + small / 2);
+    EXPECT_EQ(whole.threads, 0);
+    EXPECT_EQ(whole.listsBudget, 0u);
+
+    const std::size_t large = quarterCost(10).memory;
+    const MemPlan lazy = planMemory({20}, 4, reservedBytes + threadBytes
+                                             + large - 1);
+    EXPECT_NE(lazy.threads, 0);
+    EXPECT_NE(lazy.listsBudget, 0u);
+    EXPECT_LT(lazy.listsBudget, large);
+}
+
+/* Odd sizes: starts without diagonal symmetry choose the half to store
+ * (see Quadrants1::fillWest) by estimates shared within a team.
+ */
+TEST(SolCounterTest, Threads)
+{
+    for (int threads: {1, 3, 4})
+    {
+        Scheduler sch(threads);
+        const auto quarter = std::make_shared<QuarterFor<6>>(threads);
+        EXPECT_EQ(countSolutions<13>(sch, Divider{}, quarter, 0), 73712u);
+        EXPECT_EQ(countSolutions<12>(sch, Divider{}, quarter, 0), 14200u);
+    }
+}
@@ -45,18 +45,16 @@ public:
         return columns_;
     }
 
+    /* Diagonals (for north and south quarters) which are attacked by
+     * the two queens in middle row/column.
+     */
     template <int offset>
-    bool matchDiags(const auto& diags) const
+    auto quarterMasks() const
     {
-        return qMatch<offset + qOffset_>(diags.first[0],  diags_[0])
-            && qMatch<offset           >(diags.second[0], diags_[0])
-            && qMatch<offset           >(diags.first[1],  diags_[1])
-            && qMatch<offset + qOffset_>(diags.second[1], diags_[1]);
-    }
-
-    static constexpr bool internalSymmetry()
-    {
-        return false;
+        return std::array<std::array<uint32_t, 2>, 2>{{
+            {qMask<offset + qOffset_>(diags_[0]), qMask<offset>(diags_[1])},
+            {qMask<offset>(diags_[0]), qMask<offset + qOffset_>(diags_[1])},
+        }};
     }
 
     static constexpr bool diagSymmetry()
@@ -69,30 +67,58 @@ public:
         return true;
     }
 
+    /* Queens in middle row/column: "col" (in middle row) is used for
+     * quad.setSBit and for all rows of middle column.
+     */
     uint64_t forCR(auto& env, auto& quad)
     {
         uint64_t res = 0;
 
         for (int col = halfSize_ + 1; col != size - 2; ++col)
         {
+            if (env.divider.skip(colItems(col))) continue;
             quad.setSBit(env, col - 1);
 
             for (int row = col + 1; row != size - 1; ++row)
             {
                 setColumnRow(col, row);
                 env.sink.setHoles(mkHoles());
-                res += 8 * quad(env);
+                res += symmetryFactor() * quad(env);
             }
         }
 
         return res;
     }
 
+    // Every solution counted stands for its rotations and reflections
+    static constexpr uint64_t symmetryFactor()
+    {
+        return 8;
+    }
+
+    // Number of work items (see Divider)
+    static constexpr uint64_t workItems()
+    {
+        uint64_t res = 0;
+
+        for (int col = halfSize_ + 1; col != size - 2; ++col)
+            res += colItems(col);
+
+        return res;
+    }
+
 protected:
+    // Work items for given column (row combinations for all its rows)
+    static constexpr uint64_t colItems(int col)
+    {
+        return (size - 2 - col) * BitComb<size - 2, halfSize_>::size();
+    }
+
+    // Bits of quarter's diagonals which would meet d after shifting by offset
     template <int offset>
-    static bool qMatch(const uint64_t q, const uint64_t d)
+    static uint32_t qMask(const uint64_t d)
     {
-        return ((q << offset) & d) == 0;
+        return static_cast<uint32_t>(d >> offset);
     }
 
     void setColumnRow(const int col, const int row)
@@ -135,6 +161,12 @@ public:
         return false;
     }
 
+    // Number of work items (see Divider): row combinations for each column
+    static constexpr uint64_t workItems()
+    {
+        return (size - 2 - size / 2) * BitComb<size - 2, size / 2>::size();
+    }
+
     uint64_t forCR(auto& env, const auto& quad)
     {
         uint64_t res = 0;
@@ -143,7 +175,7 @@ public:
         {
             this->setColumnRow(col, size - 1);
             env.sink.setHoles(this->mkHoles());
-            res += 8 * quad(env);
+            res += this->symmetryFactor() * quad(env);
         }
 
         return res;
@@ -1,8 +1,10 @@
 #ifndef STARTCENTER_H
 #define STARTCENTER_H
 
+#include <array>
 #include <cstdint>
 
+#include "bitcombsymm.h"
 #include "cfg.h"
 #include "sieve.h"
 #include "util.h"
@@ -17,9 +19,10 @@ class StartCenter
 public:
     using Sieve_ = Sieve<Match, cfg, size - 2, 1>;
 
+    // Both mirror images keep the queen in the center
     auto getBitComb() const
     {
-        return BitComb<size - 1, halfSize_>{};
+        return Comb_{};
     }
 
     uint32_t stretchRows(uint32_t bits) const
@@ -38,19 +41,25 @@ public:
         return centerBit_;
     }
 
+    /* Diagonals (for north and south quarters) which are attacked by
+     * the queen in the center.
+     */
     template <int offset>
-    bool matchDiags(const auto& diags) const
+    auto quarterMasks() const
     {
-        static constexpr int flip = (offset != 0);
+        static constexpr uint32_t flip = (offset != 0);
         static constexpr auto middle = uint32_t{1} << (halfSize_ - 1);
 
-        return (diags.first[0 ^ flip] & middle) == 0
-            && (diags.second[1 ^ flip] & middle) == 0;
+        return std::array<std::array<uint32_t, 2>, 2>{{
+            {middle * (1 - flip), middle * flip},
+            {middle * flip, middle * (1 - flip)},
+        }};
     }
 
-    static constexpr bool internalSymmetry()
+    // Number of work items (see Divider)
+    static constexpr uint64_t workItems()
     {
-        return true;
+        return Comb_::size();
     }
 
     static constexpr bool diagSymmetry()
@@ -67,6 +76,8 @@ private:
     static constexpr uint32_t allRC_ = nLeastBits<uint32_t>(size);
     static constexpr int halfSize_ = size / 2;
     static constexpr uint32_t centerBit_ = uint32_t{1} << halfSize_;
+
+    using Comb_ = BitCombSymm<BitComb, size - 1, halfSize_, EastWest::joint>;
 };
 
 #endif // STARTCENTER_H
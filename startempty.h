@@ -3,6 +3,7 @@
 
 #include <cstdint>
 
+#include "bitcombsymm.h"
 #include "cfg.h"
 #include "sieve.h"
 #include "util.h"
@@ -19,7 +20,7 @@ public:
 
     auto getBitComb() const
     {
-        return BitComb<size, size / 2>{};
+        return Comb_{};
     }
 
     uint32_t stretchRows(uint32_t bits) const
@@ -43,9 +44,10 @@ public:
         return true;
     }
 
-    static constexpr bool internalSymmetry()
+    // Number of work items (see Divider)
+    static constexpr uint64_t workItems()
     {
-        return true;
+        return Comb_::size();
     }
 
     static constexpr bool diagSymmetry()
@@ -60,6 +62,8 @@ public:
 
 private:
     static constexpr uint32_t allRC_ = nLeastBits<uint32_t>(size);
+
+    using Comb_ = BitCombSymm<BitComb, size, size / 2, EastWest::separate>;
 };
 
 #endif // STARTEMPTY_H
@@ -3,17 +3,22 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
-#include <functional>
 #include <memory>
 #include <numeric>
 #include <ranges>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "board.h"
 #include "foreach2.h"
+#include "mappedvector.h"
+#include "qdiags.h"
+#include "qgenerator.h"
+#include "scheduler.h"
 
 /* Generates and stores all partial solutions for n-queen problem for part
  * of the chessboard (where this part is occupied by 0..k queens). Then
@@ -22,15 +27,22 @@
  * sets of occupied rows/columns).
  *
  * Sets of occupied rows/columns/diagonals are implemented as bitsets and
- * stored as uint32_t values. Indexing also uses 32-bit integers which
- * should be enough for quarter-boards of size up to 13 (whole chessboard
- * of size up to 27). A combination of sets of rows and columns is named here
- * as "cell".
+ * stored as uint32_t values. Indexing uses 32-bit integers for quarter-boards
+ * of size up to 12 (whole chessboard of size up to 25) and 64-bit integers
+ * for larger ones. Storage may keep both the index and the lists in memory
+ * mapped files (see qdiags.h). A combination of sets of rows and columns is
+ * named here as "cell".
  *
- * Partial solutions are computed with backtracking algorithm: placeQueens()
- * is recursively called to place a queen in the first row, second one, etc.
- * Bitwise operations (see board.h) are perfect fit for this task
- * (run quickly and are easy to implement).
+ * Partial solutions are produced by Generator (see qgenerator.h), either
+ * with backtracking algorithm or by extending solutions for the smaller
+ * quarter-board. Constructor may use several threads: every
+ * generator's task produces solutions for its own sets of rows. Resulting
+ * layout does not depend on the number of threads.
+ *
+ * Generation is done twice: first pass only counts solutions for each cell
+ * (to compute the index), second pass writes every solution directly to its
+ * final position. This costs some CPU time but avoids temporary storage
+ * for all solutions (which is as large as the table itself).
  *
  * Template parameters:
  * size - size of the quarter-board
@@ -40,10 +52,15 @@
  *            in the main algorithm
  * Packer - a class controlling how index is stored in memory and iterated
  *            (see pack.h)
+ * Generator - a class producing partial solutions (see qgenerator.h)
+ * Storage - a class controlling how sets of diagonals are stored
+ *            (see qdiags.h)
  */
 template <int size,
           template<int, class...> class Symmetry,
-          template<int...> class Packer>
+          template<int...> class Packer,
+          template<int> class Generator = QBacktrack,
+          template<int> class Storage = DiagsPlain>
 class Subsquare
 {
     using Pack = Packer<size>;
@@ -51,20 +68,42 @@ class Subsquare
     using CellInd = Symm::CellInd;
     using CellFactory = Symm::CellFactory;
     using Diagonals = Symm::Diagonals;
+    using Store = Storage<size>;
+    using Word = Store::Word;
+    using Masks = std::array<Diagonals, 2>;
 
-    // check that uint32_t is enough for index_
-    static_assert(size <= 12 + (Symm::factor > 4));
+    // 633M partial solutions for size 12, 6.4G for size 13
+    using Offset = std::conditional_t<(size <= 12), uint32_t, uint64_t>;
+    template<class T>
+    using Vector = Store::template Vector<T>;
 
 public:
-    Subsquare()
+    explicit Subsquare(std::ptrdiff_t threads = 1)
+        : Subsquare(threads, Generator<size>{})
+    {}
+
+    // Use given generator object instead of default one
+    Subsquare(std::ptrdiff_t threads, const auto& gen)
+        : threads_{threads}
     {
-        fill();
+        index_.resize(Pack::getLastIndex() + 1);
+        fill(gen);
     }
 
     // Prepare rows info to be used in forCells().
     auto withRows(uint32_t rows) const
     {
-        return CellFactory(rows);
+        const CellFactory cf(rows);
+
+        if constexpr (requires { diags_.willNeed(0, 0); })
+        {
+            const Offset* begin = pIndex(cf.getRowInfo().posInIndex);
+            const Offset* end = pIndex(Pack::getRowInfo(cf.getRows() + 1)
+                                       .posInIndex);
+            diags_.willNeed(*begin, *end); // start reading them from disk
+        }
+
+        return cf;
     }
 
     // Iterate all cells for given set of rows.
@@ -91,7 +130,47 @@ public:
         if (Symm::factor > 2 && ix[0] == ix[1])
             return;
 
-        forDiagsImpl<filterDiags, other>(first, second, action);
+        forDiagsImpl<filterDiags, other, false>(first, second, nullptr, action);
+    }
+
+    /* Same as above, but skip diagonals having any bit set in masks[0]
+     * (for first cell) or masks[1] (for second one). Used to apply
+     * constraints of the start position once per list element instead
+     * of checking every pair.
+     */
+    template<bool filterDiags, bool other>
+    void forDiags(const CellInd& first,
+                  const CellInd& second,
+                  const Masks& masks,
+                  const auto& action) const
+    {
+        const auto ix = pIndex(first.index);
+
+        if (Symm::factor > 2 && ix[0] == ix[1])
+            return;
+
+        forDiagsImpl<filterDiags, other, true>(first, second, masks.data(),
+                                               action);
+    }
+
+    // Number of partial solutions in the list for given cell
+    std::size_t listSize(const CellInd& ci) const
+    {
+        const auto ix = pIndex(ci.index);
+        return static_cast<std::size_t>(ix[1] - ix[0]);
+    }
+
+    /* Iterate partial solutions for given set of rows: call action(columns,
+     * diagonals). Only for tables storing all solutions (no symmetries).
+     */
+    void forRowPieces(uint32_t rows, const auto& action) const
+    requires (Symm::factor == 1)
+    {
+        Pack::forColumns(Pack::getRowInfo(rows), rows,
+                         [&, this](uint32_t ind, uint32_t columns) {
+            for (Offset i = index(ind); i != index(ind + 1); ++i)
+                action(columns, Store::load(diags_[i]));
+        });
     }
 
     /* Marks a bit so that we will ignore any results having non-zero diagonal
@@ -99,8 +178,44 @@ public:
      */
     void setSBit(int bitPos)
     {
+        if (specialBit_ == uint32_t{1} << bitPos)
+            return; // already partitioned
+
         specialBit_ = uint32_t{1} << bitPos;
-        partitionCells(pIndex(0), pIndex(Pack::getLastIndex()));
+        partitionRows();
+    }
+
+    /* Same as above, but called by several threads at once: lists for each
+     * set of rows are partitioned by the thread for which accepted() returns
+     * true, sync() waits for all threads. Nobody should use this object
+     * while it is working. New special bit is visible to all threads when
+     * it returns.
+     */
+    void setSBit(int bitPos, const auto& accepted, const auto& sync)
+    {
+        const uint32_t bit = uint32_t{1} << bitPos;
+
+        if (specialBit_ == bit)
+            return; // already partitioned
+
+        for (uint32_t rows = 0; rows != rcCnt_; ++rows)
+        {
+            if (accepted())
+                partitionCells(rowBegin(rows), rowEnd(rows), bit);
+        }
+
+        sync(); // every thread has seen old specialBit_
+
+        if (accepted())
+            specialBit_ = bit;
+
+        sync(); // every thread sees new specialBit_
+    }
+
+    // Return special bit to its initial position (center)
+    void resetSBit()
+    {
+        setSBit(size - 1);
     }
 
     // Indicates that no additional check is needed for special bit.
@@ -109,25 +224,44 @@ public:
         return Symm::factor <= 2;
     }
 
-private:
-    struct Piece
+    /* Estimated memory needed for the table holding given number of partial
+     * solutions (memory mapped files are not counted).
+     */
+    static constexpr std::size_t estimateBytes(uint64_t pieces)
     {
-        uint32_t columns;
-        std::array<uint32_t, 2> diags;
-    };
+        return mapped_ ? 0 : tableBytes(pieces);
+    }
 
+    // Same as above, but for the size of memory mapped files
+    static constexpr std::size_t estimateFileBytes(uint64_t pieces)
+    {
+        return mapped_ ? tableBytes(pieces) : 0;
+    }
+
+private:
     static constexpr uint32_t rcCnt_ = 1 << size;
-    using UnsortedRow = std::vector<Piece>;
-    using Unsorted = std::array<UnsortedRow, rcCnt_>;
-    using Index = std::array<uint32_t, Pack::getLastIndex() + 1>;
+    static constexpr bool mapped_ =
+            std::is_same_v<Vector<Word>, MappedVector<Word>>;
+
+    static constexpr std::size_t tableBytes(uint64_t pieces)
+    {
+        return (Pack::getLastIndex() + 1) * sizeof(Offset)
+                + pieces / Symm::factor * sizeof(Word);
+    }
 
-    template<bool filter, bool other>
+    template<bool filter, bool other, bool masked>
     void forDiagsImpl(const CellInd& first,
                       const auto& second,
+                      const Diagonals* mask,
                       const auto& action) const
     {
-        auto next = [&, this](Diagonals d) {
-            forDiagsImpl<filter, !other>(second, Symm::fix(d, first), action);
+        auto next = [&, this](const Word& w) {
+            const Diagonals d = Symm::fix(Store::load(w), first);
+
+            if (masked && ((d[0] & (*mask)[0]) | (d[1] & (*mask)[1])))
+                return;
+
+            forDiagsImpl<filter, !other, masked>(second, d, mask + 1, action);
         };
 
         namespace r = std::ranges;
@@ -152,130 +286,137 @@ private:
         }
     }
 
-    template<bool, bool>
+    template<bool, bool, bool>
     void forDiagsImpl(const Diagonals& first,
                       const Diagonals& second,
+                      const Diagonals*,
                       const auto& action) const
     {
         action(std::make_pair(first, second));
     }
 
     // Produce all partial solutions for [0..size] queens on chessboard.
-    void fill()
+    void fill(const auto& gen)
     {
-        Board<size> board;
-        auto pSink = std::make_unique<Unsorted>();
+        // Tasks touch disjoint parts of index_ and diags_
+        auto forPieces = [&](const auto& action) {
+            parallelFor(threads_, gen.taskCnt, [&](uint32_t task) {
+                gen.forTask(task, [&](const Board<size>& board) {
+                    if (Symm::isUniq(board.rows(), board.columns()))
+                        action(board);
+                });
+            });
+        };
 
-        if constexpr (requires {UnsortedRow{}.reserve(1);} && size > 11)
-        {
-            /* Try to allocate this using mmap (>=128K for each allocation)
-             * so that temporary data do not bloat sbrk space (use vector) */
-            for (UnsortedRow& r: *pSink)
-                r.reserve(130 * 1024 / sizeof(Piece));
-        }
+        forPieces([this](const auto& board) {
+            ++index(cellIndex(board));
+        });
+
+        makeIndex();
 
-        placeQueens(board, 0, *pSink);
-        diags_.reserve(std::transform_reduce(pSink->begin(), pSink->end(),
-            0ull, std::plus<>(), [](const auto& c){ return c.size(); }));
+        forPieces([this](const auto& board) {
+            diags_[--index(cellIndex(board))] =
+                    Store::store({board.diags(0), board.diags(1)});
+        });
 
-        for (uint32_t rows = 0; UnsortedRow& r: *pSink)
-            reorder(rows++, r);
+        partitionRows();
     }
 
-    // Recursively place queens to get all partial solutions
-    static void placeQueens(const Board<size>& board,
-                            const unsigned row,
-                            Unsorted& sink)
+    static uint32_t cellIndex(const Board<size>& board)
     {
-        if (row == size)
-        {
-            addPiece(board, sink);
-            return;
-        }
+        return Pack::getColIndex(Pack::getRowInfo(board.rows()),
+                                 board.columns());
+    }
+
+    /* Turn solution counts (stored in index) to positions where each cell's
+     * list ends, allocate diags_ accordingly. Partial sums are computed
+     * for each set of rows in parallel, then shifted by offsets of rows.
+     */
+    void makeIndex()
+    {
+        parallelFor(threads_, rcCnt_, [this](uint32_t rows) {
+            std::partial_sum(rowBegin(rows), rowEnd(rows), rowBegin(rows));
+        });
 
-        uint32_t columns = board.getFreeColumns(row);
+        using Offsets = std::array<Offset, rcCnt_>;
+        auto pOffsets = std::make_unique<Offsets>();
+        Offset total = 0;
 
-        while (columns != 0)
+        for (uint32_t rows = 0; rows != rcCnt_; ++rows)
         {
-            uint32_t firstBit = columns & -columns;
-            placeQueens(board.addQueen(row, firstBit), row + 1, sink);
-            columns ^= firstBit;
+            (*pOffsets)[rows] = total;
+            total += rowEnd(rows)[-1];
         }
 
-        placeQueens(board, row + 1, sink); // empty row
-    }
+        parallelFor(threads_, rcCnt_, [&, this](uint32_t rows) {
+            const Offset offset = (*pOffsets)[rows];
+            for (Offset* it = rowBegin(rows); it != rowEnd(rows); ++it)
+                *it += offset;
+        });
 
-    // Record a single solution (if needed)
-    static void addPiece(const Board<size>& board, Unsorted& sink)
-    {
-        if (Symm::isUniq(board.rows(), board.columns()))
-            sink[board.rows()].emplace_back(
-                  board.columns(), Diagonals{board.diags(0), board.diags(1)});
+        index(Pack::getLastIndex()) = total;
+        diags_.resize(total);
     }
 
-    // Move solutions to permanent locations and update index
-    void reorder(const uint32_t rows, UnsortedRow& rowData)
+    // Apply partitionCells to every set of rows (in parallel)
+    void partitionRows()
     {
-        auto ri = Pack::getRowInfo(rows);
-        auto ri1 =  Pack::getRowInfo(rows + 1);
-        uint32_t* const dstBegin = pIndex(ri.posInIndex);
-        uint32_t* const dstEnd = pIndex(ri1.posInIndex);
-        std::fill(dstBegin, dstEnd, 0);
-        *dstBegin = static_cast<uint32_t>(diags_.size());
-        diags_.resize(diags_.size() + rowData.size());
-
-        for (const Piece& piece: rowData)
-            ++index(Pack::getColIndex(ri, piece.columns));
-
-        std::partial_sum(dstBegin, dstEnd, dstBegin);
-
-        for (const Piece& piece: rowData)
-            diags_[--index(Pack::getColIndex(ri, piece.columns))] = piece.diags;
-
-        *dstEnd = static_cast<uint32_t>(diags_.size());
-        partitionCells(dstBegin, dstEnd);
-        rowData.clear();
-        rowData.shrink_to_fit();
+        parallelFor(threads_, rcCnt_, [this](uint32_t rows) {
+            partitionCells(rowBegin(rows), rowEnd(rows), specialBit_);
+        });
     }
 
-    // Move solutions having nonzero special bit closer to each other
-    void partitionCells(const uint32_t* begin, const uint32_t* end)
+    // Apply partitionDiags to every cell for given set of rows
+    void partitionCells(const Offset* begin,
+                        const Offset* end,
+                        const uint32_t bit)
     {
-        for (const uint32_t* it = begin; it != end; ++it)
+        for (const Offset* it = begin; it != end; ++it)
         {
-            namespace r = std::ranges;
-            auto wholeR = r::subrange(&diags_[*it], &diags_[it[1]]);
-            auto bit1R = r::partition(wholeR, hasZeroSBit(0));
-            auto bit0R = r::subrange(wholeR.begin(), bit1R.begin());
-            r::partition(bit0R, hasZeroSBit(1));
-            r::partition(bit1R, std::not_fn(hasZeroSBit(1)));
+            auto wholeR = std::ranges::subrange(&diags_[*it], &diags_[it[1]]);
+            partitionDiags<Store>(wholeR, bit);
         }
     }
 
     auto hasZeroSBit(int whichDiag) const
     {
-        return [whichDiag, this](Diagonals d) {
-            return (d[whichDiag] & specialBit_) == 0;
-        };
+        return hasZeroBit<Store>(whichDiag, specialBit_);
+    }
+
+    Offset& index(auto pos)
+    {
+        return index_[pos];
+    }
+
+    const Offset& index(auto pos) const
+    {
+        return index_[pos];
+    }
+
+    Offset* pIndex(auto pos)
+    {
+        return index_.data() + pos;
     }
 
-    uint32_t& index(auto pos)
+    const Offset* pIndex(auto pos) const
     {
-        return (*index_)[pos];
+        return index_.data() + pos;
     }
 
-    const uint32_t& index(auto pos) const
+    // Index elements for given set of rows
+    Offset* rowBegin(uint32_t rows)
     {
-        return (*index_)[pos];
+        return pIndex(Pack::getRowInfo(rows).posInIndex);
     }
 
-    uint32_t* pIndex(auto pos) const
+    Offset* rowEnd(uint32_t rows)
     {
-        return index_->data() + pos;
+        return rowBegin(rows + 1);
     }
 
-    std::unique_ptr<Index> index_ = std::make_unique<Index>();
-    std::vector<Diagonals> diags_;
+    Vector<Offset> index_;
+    Vector<Word> diags_;
+    std::ptrdiff_t threads_;
     uint32_t specialBit_ = uint32_t{1} << (size - 1);
 };
 
@@ -104,3 +104,113 @@ TEST(SubsquareTest, ForDiagsFiltered1)
 {
     testSubsquare<true, true>(filtered);
 }
+
+namespace {
+std::vector<D2> collectDiags(const auto& q, int size)
+{
+    std::vector<D2> dList;
+    const auto empty = q.withRows(0).makeCellInd(0u);
+
+    for (uint32_t rows = 0; rows != (uint32_t{1} << size); ++rows)
+    {
+        const auto factory = q.withRows(rows);
+
+        q.forCells(factory, [&](const auto& cell) {
+            const auto ci = factory.makeCellInd(cell);
+            q.template forDiags<false, false>(empty, ci, [&](const auto& d) {
+                dList.push_back(d.second);
+            });
+        });
+    }
+
+    return dList;
+}
+}
+
+TEST(SubsquareTest, LayoutDoesNotDependOnThreads)
+{
+    static constexpr int size = 7;
+    const Subsquare<size, QNoSymmetry, PackIter> single;
+    const Subsquare<size, QNoSymmetry, PackIter> multi(4);
+
+    EXPECT_EQ(collectDiags(single, size), collectDiags(multi, size));
+}
+
+TEST(SubsquareTest, Storage)
+{
+    static constexpr int size = 9;
+    const Subsquare<size, QNoSymmetry, PackIter> plain;
+    const Subsquare<size, QNoSymmetry, PackIter, QBacktrack, DiagsPacked> pk;
+    const Subsquare<size, QNoSymmetry, PackIter, QBacktrack, DiagsMapped> mp;
+    const auto plainList = collectDiags(plain, size);
+
+    EXPECT_EQ(collectDiags(pk, size), plainList);
+    EXPECT_EQ(collectDiags(mp, size), plainList);
+}
+
+TEST(SubsquareTest, ForDiagsMasked)
+{
+    static constexpr int size = 6;
+    const Subsquare<size, QRowSymmetry, PackIter> q;
+    const std::array<D2, 2> masks {{{0x12, 0x40}, {0x08, 0x101}}};
+    const auto first = q.withRows(0x0B).makeCellInd(0x15u);
+
+    auto compatible = [](const D2& d, const D2& mask) {
+        return (d[0] & mask[0]) == 0 && (d[1] & mask[1]) == 0;
+    };
+
+    for (uint32_t columns = 0; columns != (uint32_t{1} << size); ++columns)
+    {
+        const auto second = q.withRows(0x32).makeCellInd(columns);
+        std::vector<std::pair<D2, D2>> expected;
+        std::vector<std::pair<D2, D2>> actual;
+
+        q.forDiags<false, false>(first, second, [&](const auto& d) {
+            if (compatible(d.first, masks[0]) && compatible(d.second, masks[1]))
+                expected.push_back(d);
+        });
+
+        q.forDiags<false, false>(first, second, masks, [&](const auto& d) {
+            actual.push_back(d);
+        });
+
+        EXPECT_EQ(actual, expected);
+    }
+}
+
+TEST(SubsquareTest, SharedSetSBit)
+{
+    static constexpr int size = 7;
+    Subsquare<size, QNoSymmetry, PackIter> single;
+    Subsquare<size, QNoSymmetry, PackIter> shared;
+    Scheduler sch(3);
+
+    single.setSBit(4);
+    sch.launch([&](auto& thread) {
+        shared.setSBit(4,
+                       [&] { return thread.accepted(); },
+                       [&] { thread.sync(); });
+        return uint64_t{0};
+    });
+
+    EXPECT_EQ(collectDiags(shared, size), collectDiags(single, size));
+}
+
+TEST(SubsquareTest, ListSize)
+{
+    static constexpr int size = 7;
+    const Subsquare<size, QNoSymmetry, PackIter> q;
+    std::size_t total = 0;
+
+    for (uint32_t rows = 0; rows != (uint32_t{1} << size); ++rows)
+    {
+        const auto factory = q.withRows(rows);
+
+        q.forCells(factory, [&](const auto& cell) {
+            total += q.listSize(factory.makeCellInd(cell));
+        });
+    }
+
+    EXPECT_EQ(total, collectDiags(q, size).size());
+    EXPECT_EQ(total, 16870u); // all placements of 0..7 queens on 7x7 board
+}
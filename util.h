@@ -84,10 +84,15 @@ constexpr uint64_t factorial(const int n)
     return fct;
 }
 
+// Computed without factorials, which overflow for n > 20
 constexpr uint32_t combinations(const int n, const int k)
 {
-    return static_cast<uint32_t>(
-        factorial(n) / factorial(k) / factorial(n - k));
+    uint64_t res = 1;
+
+    for (int i = 0; i != k; ++i)
+        res = res * static_cast<uint64_t>(n - i) / static_cast<uint64_t>(i + 1);
+
+    return static_cast<uint32_t>(res);
 }
 
 #endif // UTIL_H
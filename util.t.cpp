@@ -87,4 +87,5 @@ TEST(UtilTest, Combinations)
     EXPECT_EQ(combinations(3, 2), 3u);
     EXPECT_EQ(combinations(4, 2), 6u);
     EXPECT_EQ(combinations(10, 5), 252u);
+    EXPECT_EQ(combinations(26, 13), 10400600u);
 }
@@ -0,0 +1,237 @@
+#ifndef WORKPLAN_H
+#define WORKPLAN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/* Balanced partitioning of work items (see Divider) between several parts.
+ * Work items are grouped into chunks of consecutive items. Cost of each
+ * chunk is either estimated (from sizes of quarter-board lists, for
+ * a sample of items) or measured by earlier runs (wall time of every item
+ * processed, saved with writeTimings). Measured chunks are preferred,
+ * estimates of other chunks are scaled to the same units. Then chunks
+ * are assigned to parts by longest-processing-time-first scheduling.
+ *
+ * Costs are added concurrently (every item by a single thread).
+ */
+class WorkPlan
+{
+public:
+    using Range = std::pair<uint64_t, uint64_t>;
+
+    enum class Mode
+    {
+        estimate, // items are not processed, only their costs are estimated
+        record    // items are processed and timed
+    };
+
+    WorkPlan(Mode mode, uint64_t totalItems)
+        : mode_(mode)
+        , total_(totalItems)
+        , chunkSize_(std::max<uint64_t>(1, (totalItems + maxChunks - 1)
+                                           / maxChunks))
+        , stride_(std::max<uint64_t>(1, chunkSize_ / samplesPerChunk))
+        , chunks_((totalItems + chunkSize_ - 1) / chunkSize_)
+    {}
+
+    bool estimating() const
+    {
+        return mode_ == Mode::estimate;
+    }
+
+    bool recording() const
+    {
+        return mode_ == Mode::record;
+    }
+
+    // Only some items are estimated, each of them stands for "stride" items
+    bool sampled(uint64_t item) const
+    {
+        return item % stride_ == 0;
+    }
+
+    void addEstimate(uint64_t item, double cost)
+    {
+        atomicAdd(chunk(item).estimate, cost * static_cast<double>(stride_));
+    }
+
+    void addTime(uint64_t item, double seconds)
+    {
+        Chunk& c = chunk(item);
+        atomicAdd(c.seconds, seconds);
+        c.timedItems.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Timings of chunks having timed items: "first last items seconds"
+    void writeTimings(std::ostream& os) const
+    {
+        for (std::size_t i = 0; i != chunks_.size(); ++i)
+        {
+            const Chunk& c = chunks_[i];
+
+            if (const uint64_t items = c.timedItems.load())
+            {
+                const auto [first, last] = chunkRange(i);
+                os << first << ' ' << last << ' ' << items << ' '
+                   << c.seconds.load() << '\n';
+            }
+        }
+    }
+
+    /* Reads timings written by earlier runs of the same program (same
+     * board size and configuration). Several files may be read in turn.
+     */
+    bool readTimings(std::istream& is)
+    {
+        uint64_t first, last, items;
+        double seconds;
+
+        while (is >> first >> last >> items >> seconds)
+        {
+            if (first % chunkSize_ != 0 || first / chunkSize_ >= chunks_.size())
+                return false;
+
+            Chunk& c = chunks_[first / chunkSize_];
+            atomicAdd(c.seconds, seconds);
+            c.timedItems += items;
+        }
+
+        return is.eof();
+    }
+
+    /* Assigns chunks to parts (longest processing time first), returns
+     * ranges of items (merged where adjacent) and total cost for every
+     * part.
+     */
+    std::vector<std::pair<std::vector<Range>, double>> assign(int parts) const
+    {
+        const std::vector<double> costs = chunkCosts();
+        std::vector<std::size_t> order(chunks_.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::stable_sort(order, std::greater{},
+                                 [&costs](std::size_t i) { return costs[i]; });
+
+        using Load = std::pair<double, int>; // cost, part
+        std::priority_queue<Load, std::vector<Load>, std::greater<>> loads;
+        std::vector<std::vector<std::size_t>> chunksOf(parts);
+
+        for (int p = 0; p != parts; ++p)
+            loads.push({0.0, p});
+
+        for (std::size_t i: order)
+        {
+            auto [load, p] = loads.top();
+            loads.pop();
+            chunksOf[p].push_back(i);
+            loads.push({load + costs[i], p});
+        }
+
+        std::vector<std::pair<std::vector<Range>, double>> res(parts);
+
+        for (int p = 0; p != parts; ++p)
+        {
+            std::ranges::sort(chunksOf[p]);
+
+            for (std::size_t i: chunksOf[p])
+            {
+                const Range r = chunkRange(i);
+                auto& ranges = res[p].first;
+
+                if (!ranges.empty() && ranges.back().second == r.first)
+                    ranges.back().second = r.second;
+                else
+                    ranges.push_back(r);
+
+                res[p].second += costs[i];
+            }
+        }
+
+        return res;
+    }
+
+    // Chunk costs: measured time or scaled estimate
+    std::vector<double> chunkCosts() const
+    {
+        double timedSeconds = 0;
+        double timedEstimate = 0;
+
+        for (const Chunk& c: chunks_)
+        {
+            if (c.timedItems.load() != 0)
+            {
+                timedSeconds += c.seconds.load();
+                timedEstimate += c.estimate.load();
+            }
+        }
+
+        const double scale = (timedSeconds > 0 && timedEstimate > 0)
+                ? timedSeconds / timedEstimate
+                : 1.0;
+
+        std::vector<double> costs;
+
+        for (std::size_t i = 0; i != chunks_.size(); ++i)
+        {
+            const Chunk& c = chunks_[i];
+            const auto [first, last] = chunkRange(i);
+            const auto items = static_cast<double>(last - first);
+            const uint64_t timed = std::min(c.timedItems.load(), last - first);
+
+            if (timed != 0)
+                costs.push_back(c.seconds.load() * items
+                                / static_cast<double>(timed));
+            else
+                costs.push_back(c.estimate.load() * scale);
+        }
+
+        return costs;
+    }
+
+private:
+    struct Chunk // value-initialized (zero)
+    {
+        std::atomic<double> estimate;
+        std::atomic<double> seconds;
+        std::atomic<uint64_t> timedItems;
+    };
+
+    static void atomicAdd(std::atomic<double>& a, double value)
+    {
+        double old = a.load(std::memory_order_relaxed);
+
+        while (!a.compare_exchange_weak(old, old + value,
+                                        std::memory_order_relaxed))
+        {}
+    }
+
+    Chunk& chunk(uint64_t item)
+    {
+        return chunks_[item / chunkSize_];
+    }
+
+    Range chunkRange(std::size_t i) const
+    {
+        const uint64_t first = i * chunkSize_;
+        return {first, std::min(first + chunkSize_, total_)};
+    }
+
+    static constexpr uint64_t maxChunks = 4096;
+    static constexpr uint64_t samplesPerChunk = 16;
+
+    Mode mode_;
+    uint64_t total_;
+    uint64_t chunkSize_;
+    uint64_t stride_;
+    std::vector<Chunk> chunks_;
+};
+
+#endif // WORKPLAN_H
@@ -0,0 +1,84 @@
+#include "workplan.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+using Range = WorkPlan::Range;
+
+// Chunk size is 1 for small number of items, every item is sampled
+TEST(WorkPlanTest, LongestFirst)
+{
+    WorkPlan plan(WorkPlan::Mode::estimate, 6);
+
+    for (uint64_t item = 0; double cost: {5.0, 3.0, 3.0, 2.0, 2.0, 1.0})
+    {
+        EXPECT_TRUE(plan.sampled(item));
+        plan.addEstimate(item++, cost);
+    }
+
+    const auto parts = plan.assign(2);
+    ASSERT_EQ(parts.size(), 2u);
+    EXPECT_EQ(parts[0].first, (std::vector<Range>{{0, 1}, {3, 4}, {5, 6}}));
+    EXPECT_EQ(parts[0].second, 8.0);
+    EXPECT_EQ(parts[1].first, (std::vector<Range>{{1, 3}, {4, 5}}));
+    EXPECT_EQ(parts[1].second, 8.0);
+}
+
+// Items of any chunk are assigned together, all items are assigned once
+TEST(WorkPlanTest, Chunks)
+{
+    static constexpr uint64_t total = 100000;
+    WorkPlan plan(WorkPlan::Mode::estimate, total);
+
+    for (uint64_t item = 0; item != total; ++item)
+    {
+        if (plan.sampled(item))
+            plan.addEstimate(item, 1.0);
+    }
+
+    std::vector<Range> all;
+    double totalCost = 0;
+
+    for (const auto& [ranges, cost]: plan.assign(3))
+    {
+        all.insert(all.end(), ranges.begin(), ranges.end());
+        totalCost += cost;
+    }
+
+    std::ranges::sort(all);
+    uint64_t pos = 0;
+
+    for (const auto& [first, last]: all)
+    {
+        EXPECT_EQ(first, pos);
+        pos = last;
+    }
+
+    EXPECT_EQ(pos, total);
+    EXPECT_NEAR(totalCost, static_cast<double>(total), total * 0.01);
+}
+
+// Timings replace estimates, other estimates are scaled
+TEST(WorkPlanTest, Timings)
+{
+    WorkPlan recorded(WorkPlan::Mode::record, 4);
+    recorded.addTime(1, 6.0);
+    recorded.addTime(2, 1.0);
+    std::stringstream ss;
+    recorded.writeTimings(ss);
+
+    WorkPlan plan(WorkPlan::Mode::estimate, 4);
+
+    for (uint64_t item = 0; item != 4; ++item)
+        plan.addEstimate(item, 10.0);
+
+    ASSERT_TRUE(plan.readTimings(ss));
+    EXPECT_EQ(plan.chunkCosts(), (std::vector{3.5, 6.0, 1.0, 3.5}));
+
+    std::stringstream bad("5 6 1 1.0\n");
+    EXPECT_FALSE(plan.readTimings(bad));
+}